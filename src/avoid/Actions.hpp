@@ -2,41 +2,12 @@
 #define __ACTIONS_HPP__
 
 #include "base/BehaviorTree.hpp"
+#include "base/CoroutineAction.hpp"
 #include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include "base/Pool.hpp"
 #include "base/RectRenderComponent.hpp"
-
-#include <iostream>
-
-static bool moveToward(GameObject& gameObject, float x, float y, float speed)
-{
-    std::cout << "moveToward" << std::endl;
-    const float epsilon = 0.01;
-
-    float dX = x - gameObject.x();
-    float dY = y - gameObject.y();
-    const float len = sqrtf(dX * dX + dY * dY);
-    if (len < epsilon) {
-        return true;
-    } else {
-        const float scale = std::min(len, speed);
-        dX = dX / len * scale;
-        dY = dY / len * scale;
-
-        gameObject.setX(gameObject.x() + dX);
-        gameObject.setY(gameObject.y() + dY);
-
-        return (speed >= len - epsilon);
-    }
-}
-
-// return true if gameobject is less than distance from x,y
-static bool isNear(const GameObject& gameObject, float x, float y, float distance)
-{
-    const float dX = x - gameObject.x();
-    const float dY = y - gameObject.y();
-    const float lensqr = dX * dX + dY * dY;
-    return lensqr <= distance * distance;
-}
+#include "base/Steering.hpp"
 
 //-----------------------------------------------------------------------------
 
@@ -46,7 +17,7 @@ static bool isNear(const GameObject& gameObject, float x, float y, float distanc
 
 // };
 
-class RushWaitAction : public BehaviorNode {
+class RushWaitAction : public CoroutineAction {
 public:
     RushWaitAction(GameObject& gameObject, Uint32 duration)
         : self(gameObject)
@@ -56,23 +27,31 @@ public:
 
     virtual void onEnter() override
     {
+        CoroutineAction::onEnter();
         mBlackboard->setRushXY(mBlackboard->getPlayerPtr()->x(), mBlackboard->getPlayerPtr()->y());
-        mStartTime = SDL_GetTicks();
-        self.setRenderCompenent(std::make_shared<RectRenderComponent>(self, 0x22, 0x22, 0xdd));
+        mStartTime = mLevel->time();
+        self.setColor(0x22, 0x22, 0xdd);
     }
 
-    virtual Status update() override
+    virtual CoTask run() override
     {
-        const Uint32 now = SDL_GetTicks();
-        if (now - mStartTime >= mDuration) {
-            bool* isRushing = reinterpret_cast<bool*>(self.mData);
-            *isRushing = true;
-            std::cout << "RushWaitAction: SUCCESS" << std::endl;
+        co_await sleepUntil(mStartTime + mDuration);
 
-            return Status::SUCCESS;
-        } else {
-            return Status::RUNNING;
-        }
+        bool* isRushing = reinterpret_cast<bool*>(self.mData);
+        *isRushing = true;
+        co_return Status::SUCCESS;
+    }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        CoroutineAction::save(snapshot);
+        snapshot.write(mStartTime);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        CoroutineAction::load(reader);
+        reader.read(mStartTime);
     }
 
 private:
@@ -81,7 +60,7 @@ private:
     Uint32 mStartTime;
 };
 
-class RushAction : public BehaviorNode {
+class RushAction : public CoroutineAction {
 public:
     RushAction(GameObject& gameObject, float speed)
         : self(gameObject)
@@ -91,20 +70,20 @@ public:
 
     virtual void onEnter() override
     {
-        self.setRenderCompenent(std::make_shared<RectRenderComponent>(self, 0xdd, 0x22, 0xdd));
+        CoroutineAction::onEnter();
+        self.setColor(0xdd, 0x22, 0xdd);
     }
 
-    virtual Status update() override
+    virtual CoTask run() override
     {
         bool* isReady = reinterpret_cast<bool*>(self.mData);
         if (!isReady)
-            return Status::FAILURE;
+            co_return Status::FAILURE;
 
-        if (moveToward(self, mBlackboard->getRushX(), mBlackboard->getRushY(), mSpeed)) {
-            *isReady = false;
-            std::cout << "RushAction: Finished" << std::endl;
-        }
-        return Status::SUCCESS;
+        co_await arrive(self, mBlackboard->getRushX(), mBlackboard->getRushY(), mSpeed);
+
+        *isReady = false;
+        co_return Status::SUCCESS;
     }
 
 private:
@@ -117,15 +96,17 @@ public:
     RushDetectNearbyAction(GameObject& gameObject, float distance)
         : self(gameObject)
         , mDistance(distance)
+        , mSensor(-1)
     {
     }
 
     virtual Status update() override
     {
-        if (isNear(self, mBlackboard->getPlayerPtr()->x(), mBlackboard->getPlayerPtr()->y(), mDistance)) {
+        mSensor = mLevel->sensors().ensure(mSensor, self, mBlackboard->getPlayerPtr(), mDistance);
+        if (mLevel->sensors().isNear(mSensor)) {
             return Status::SUCCESS;
         } else {
-            self.setRenderCompenent(std::make_shared<RectRenderComponent>(self, 0x22, 0xdd, 0x22));
+            self.setColor(0x22, 0xdd, 0x22);
             return Status::FAILURE;
         }
     }
@@ -133,6 +114,7 @@ public:
 private:
     GameObject& self;
     float mDistance;
+    int mSensor;
 };
 
 class IsRushingCondition : public BehaviorNode {
@@ -146,10 +128,8 @@ public:
     {
         bool* isRushing = reinterpret_cast<bool*>(self.mData);
         if (*isRushing) {
-            std::cout << "IsRushingCondition: SUCCESS" << std::endl;
             return Status::SUCCESS;
         } else {
-            std::cout << "IsRushingCondition: FAILURE" << std::endl;
             return Status::FAILURE;
         }
     }
@@ -158,40 +138,99 @@ private:
     GameObject& self;
 };
 
-class SleepAction : public BehaviorNode {
+class IsThreatenedCondition : public BehaviorNode {
+public:
+    IsThreatenedCondition(GameObject& gameObject, int tag, float threshold)
+        : self(gameObject)
+        , mTag(tag)
+        , mThreshold(threshold)
+    {
+    }
+
+    virtual Status update() override
+    {
+        float cx = self.x() + self.w() * 0.5f;
+        float cy = self.y() + self.h() * 0.5f;
+        return mLevel->influence().influence(mTag, cx, cy) >= mThreshold ? Status::SUCCESS : Status::FAILURE;
+    }
+
+private:
+    GameObject& self;
+    const int mTag;
+    const float mThreshold;
+};
+
+class IsTagNearbyCondition : public BehaviorNode {
+public:
+    IsTagNearbyCondition(GameObject& gameObject, int tag, float distance)
+        : self(gameObject)
+        , mTag(tag)
+        , mDistance(distance)
+    {
+    }
+
+    virtual Status update() override
+    {
+        float cx = self.x() + self.w() * 0.5f;
+        float cy = self.y() + self.h() * 0.5f;
+        return mLevel->objectsInRadius(cx, cy, mDistance, mTag, nullptr, 0, &self) > 0 ? Status::SUCCESS : Status::FAILURE;
+    }
+
+private:
+    GameObject& self;
+    const int mTag;
+    const float mDistance;
+};
+
+class SleepAction : public CoroutineAction {
 public:
     SleepAction(GameObject& gameObject, Uint32 duration)
         : self(gameObject)
         , mDuration(duration)
+        , mSensor(-1)
     {
     }
 
     virtual void onEnter() override
     {
-        mStartTime = SDL_GetTicks();
+        CoroutineAction::onEnter();
+        mStartTime = mLevel->time();
     }
 
-    virtual Status update() override
+    virtual CoTask run() override
     {
         bool* isSleeping = reinterpret_cast<bool*>(self.mData);
         if (*isSleeping == false) {
-            return Status::FAILURE;
+            co_return Status::FAILURE;
         }
 
-        Uint32 currentTime = SDL_GetTicks();
-        Uint32 elapsedTime = currentTime - mStartTime;
-        if (elapsedTime >= mDuration || isNear(self, mBlackboard->getPlayerPtr()->x(), mBlackboard->getPlayerPtr()->y(), SIZE * 3.5f)) {
-            *isSleeping = false;
-            return Status::SUCCESS;
-        } else {
-            return Status::RUNNING;
-        }
+        // until the player comes near, or the time is up
+        co_await until([this] {
+            mSensor = mLevel->sensors().ensure(mSensor, self, mBlackboard->getPlayerPtr(), SIZE * 3.5f);
+            return mLevel->sensors().isNear(mSensor);
+        }, mStartTime + mDuration);
+
+        *isSleeping = false;
+        co_return Status::SUCCESS;
+    }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        CoroutineAction::save(snapshot);
+        snapshot.write(mStartTime);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        CoroutineAction::load(reader);
+        reader.read(mStartTime);
     }
 
 private:
     GameObject& self;
     Uint32 mDuration;
     Uint32 mStartTime;
+    int mSensor;
 };
 
 class ChaseAction : public BehaviorNode {
@@ -205,7 +244,7 @@ public:
 
     virtual void onEnter() override
     {
-        self.setRenderCompenent(std::make_shared<RectRenderComponent>(self, 0xdd, 0x22, 0x22));
+        self.setColor(0xdd, 0x22, 0x22);
     }
 
     virtual Status update() override
@@ -213,7 +252,7 @@ public:
         std::shared_ptr<GameObject> whichShared = mWhich.lock();
 
         if (whichShared) {
-            moveToward(self, whichShared->x(), whichShared->y(), mSpeed);
+            mLevel->flowField().steer(self, *whichShared, mSpeed * mLevel->ai().elapsed(), mLevel->steering());
         }
 
         return Status::SUCCESS;
@@ -225,4 +264,45 @@ private:
     const std::weak_ptr<GameObject> mWhich;
 };
 
+class FollowPathAction : public BehaviorNode {
+public:
+    FollowPathAction(GameObject& gameObject, float speed, float x, float y)
+        : self(gameObject)
+        , mSpeed(speed)
+        , mX(x)
+        , mY(y)
+    {
+    }
+
+    virtual void onEnter() override
+    {
+        mFollower.reset();
+    }
+
+    virtual Status update() override
+    {
+        switch (mFollower.step(*mLevel, self, mX, mY, mSpeed * mLevel->ai().elapsed())) {
+        case PathFollower::Result::ARRIVED:
+            return Status::SUCCESS;
+        case PathFollower::Result::NO_PATH:
+            return Status::FAILURE;
+        default:
+            return Status::RUNNING;
+        }
+    }
+
+    // the path is not saved; it is planned again from the restored position
+    virtual void load(SnapshotReader& reader) override
+    {
+        BehaviorNode::load(reader);
+        mFollower.reset();
+    }
+
+private:
+    GameObject& self;
+    const float mSpeed;
+    const float mX, mY;
+    PathFollower mFollower;
+};
+
 #endif // __ACTIONS_HPP__
\ No newline at end of file
@@ -8,15 +8,24 @@
 #include "base/GenericComponent.hpp"
 #include "base/InputManager.hpp"
 #include "base/Level.hpp"
+#include "base/LevelLoader.hpp"
 #include "base/PatrolComponent.hpp"
+#include "base/Pool.hpp"
 #include "base/RectRenderComponent.hpp"
 #include "base/RemoveOnCollideComponent.hpp"
 #include "base/SDLGraphicsProgram.hpp"
 #include "base/StateComponent.hpp"
 #include "base/StatesAndTransitions.hpp"
+#include "base/StatsServer.hpp"
+#include "base/WorldRunner.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 static const int TAG_PLAYER = 1;
 static const int TAG_GOAL = 2;
@@ -25,6 +34,8 @@ static const int TAG_ENEMY = 4;
 
 class AvoidInputComponent : public GenericComponent {
 public:
+    static constexpr Memory::Category MEMORY_CATEGORY = Memory::INPUT;
+
     AvoidInputComponent(GameObject& gameObject, float speed)
         : GenericComponent(gameObject)
         , mSpeed(speed)
@@ -33,10 +44,10 @@ public:
 
     virtual void update(Level& level) override
     {
-        bool left = InputManager::getInstance().isKeyDown(SDLK_LEFT);
-        bool right = InputManager::getInstance().isKeyDown(SDLK_RIGHT);
-        bool up = InputManager::getInstance().isKeyDown(SDLK_UP);
-        bool down = InputManager::getInstance().isKeyDown(SDLK_DOWN);
+        bool left = level.input().isKeyDown(SDLK_LEFT);
+        bool right = level.input().isKeyDown(SDLK_RIGHT);
+        bool up = level.input().isKeyDown(SDLK_UP);
+        bool down = level.input().isKeyDown(SDLK_DOWN);
 
         GameObject& gameObject = getGameObject();
         std::shared_ptr<PhysicsComponent> pc = gameObject.physicsComponent();
@@ -67,10 +78,11 @@ public:
     AvoidPlayer(float x, float y)
         : GameObject(x, y, SIZE, SIZE, TAG_PLAYER)
     {
-        addGenericCompenent(std::make_shared<AvoidInputComponent>(*this, 10.0f));
-        addGenericCompenent(std::make_shared<RemoveOnCollideComponent>(*this, TAG_GOAL));
-        setPhysicsCompenent(std::make_shared<PhysicsComponent>(*this, false));
-        setRenderCompenent(std::make_shared<RectRenderComponent>(*this, 0x00, 0xff, 0xaa));
+        addGenericCompenent(makePooled<AvoidInputComponent>(*this, 10.0f));
+        addGenericCompenent(makePooled<RemoveOnCollideComponent>(*this, TAG_GOAL));
+        setPhysicsCompenent(makePooled<PhysicsComponent>(*this, false));
+        physicsComponent()->setLayer(TAG_PLAYER);
+        setRenderCompenent(makePooled<RectRenderComponent>(*this, 0x00, 0xff, 0xaa));
     }
 };
 
@@ -79,8 +91,9 @@ public:
     AvoidGoal(float x, float y)
         : GameObject(x, y, SIZE, SIZE, TAG_GOAL)
     {
-        setPhysicsCompenent(std::make_shared<PhysicsComponent>(*this, false));
-        setRenderCompenent(std::make_shared<RectRenderComponent>(*this, 0xff, 0xff, 0x00));
+        setPhysicsCompenent(makePooled<PhysicsComponent>(*this, false));
+        physicsComponent()->setLayer(TAG_GOAL);
+        setRenderCompenent(makePooled<RectRenderComponent>(*this, 0xff, 0xff, 0x00));
     }
 };
 
@@ -95,21 +108,34 @@ public:
         isSleeping = true;
         mData = &isSleeping;
 
-        std::shared_ptr<SleepAction> sleepAction = std::make_shared<SleepAction>(*this, 1000 * 30);
-        std::shared_ptr<Inverter> inverter = std::make_shared<Inverter>(sleepAction);
+        std::shared_ptr<SleepAction> sleepAction = makePooled<SleepAction>(*this, 1000 * 30);
+        std::shared_ptr<Inverter> inverter = makePooled<Inverter>(sleepAction);
 
-        std::shared_ptr<ChaseAction> chaseAction = std::make_shared<ChaseAction>(*this, 6.0f, player);
-        std::shared_ptr<Sequence> chaseSequence = std::make_shared<Sequence>();
+        std::shared_ptr<ChaseAction> chaseAction = makePooled<ChaseAction>(*this, 6.0f, player);
+        std::shared_ptr<Sequence> chaseSequence = makePooled<Sequence>();
 
         chaseSequence->addChild(inverter);
         chaseSequence->addChild(chaseAction);
 
-        std::shared_ptr<BehaviorTree> bt = std::make_shared<BehaviorTree>(*this);
+        std::shared_ptr<BehaviorTree> bt = makePooled<BehaviorTree>(*this);
         bt->setRoot(chaseSequence);
         addGenericCompenent(bt);
 
-        setPhysicsCompenent(std::make_shared<PhysicsComponent>(*this, true));
-        setRenderCompenent(std::make_shared<RectRenderComponent>(*this, 0xdd, 0xdd, 0xdd));
+        setPhysicsCompenent(makePooled<PhysicsComponent>(*this, true));
+        physicsComponent()->setLayer(TAG_ENEMY);
+        setRenderCompenent(makePooled<RectRenderComponent>(*this, 0xdd, 0xdd, 0xdd));
+    }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        GameObject::save(snapshot);
+        snapshot.write(isSleeping);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        GameObject::load(reader);
+        reader.read(isSleeping);
     }
 };
 
@@ -124,69 +150,295 @@ public:
         isRunning = false;
         mData = &isRunning;
         // behavior tree
-        std::shared_ptr<BehaviorTree> bt = std::make_shared<BehaviorTree>(*this);
+        std::shared_ptr<BehaviorTree> bt = makePooled<BehaviorTree>(*this);
         addGenericCompenent(bt);
 
         // first level of the tree (root)
-        std::shared_ptr<Sequence> rushSequence = std::make_shared<Sequence>();
+        std::shared_ptr<Sequence> rushSequence = makePooled<Sequence>();
         bt->setRoot(rushSequence);
 
         // second level of the tree
-        std::shared_ptr<Selector> rushSelector = std::make_shared<Selector>();
-        std::shared_ptr<RushAction> rushAction = std::make_shared<RushAction>(*this, 3.5 * 6.0f);
+        std::shared_ptr<Selector> rushSelector = makePooled<Selector>();
+        std::shared_ptr<RushAction> rushAction = makePooled<RushAction>(*this, 3.5 * 6.0f);
         rushSequence->addChild(rushSelector);
         rushSequence->addChild(rushAction);
 
         // third level of the tree
-        std::shared_ptr<IsRushingCondition> isRushingCondition = std::make_shared<IsRushingCondition>(*this);
-        std::shared_ptr<Sequence> rushSequence1 = std::make_shared<Sequence>();
+        std::shared_ptr<IsRushingCondition> isRushingCondition = makePooled<IsRushingCondition>(*this);
+        std::shared_ptr<Sequence> rushSequence1 = makePooled<Sequence>();
         rushSelector->addChild(isRushingCondition);
         rushSelector->addChild(rushSequence1);
 
         // fourth level of the tree
-        std::shared_ptr<RushDetectNearbyAction> detectNearbyAction = std::make_shared<RushDetectNearbyAction>(*this, SIZE * 7.0f);
-        std::shared_ptr<RushWaitAction> waitAction = std::make_shared<RushWaitAction>(*this, 1500);
+        std::shared_ptr<RushDetectNearbyAction> detectNearbyAction = makePooled<RushDetectNearbyAction>(*this, SIZE * 7.0f);
+        std::shared_ptr<RushWaitAction> waitAction = makePooled<RushWaitAction>(*this, 1500);
         rushSequence1->addChild(detectNearbyAction);
         rushSequence1->addChild(waitAction);
 
-        addGenericCompenent(std::make_shared<RemoveOnCollideComponent>(*this, TAG_PLAYER));
-        setPhysicsCompenent(std::make_shared<PhysicsComponent>(*this, false));
-        setRenderCompenent(std::make_shared<RectRenderComponent>(*this, 0x22, 0xdd, 0x22));
+        addGenericCompenent(makePooled<RemoveOnCollideComponent>(*this, TAG_PLAYER));
+        setPhysicsCompenent(makePooled<PhysicsComponent>(*this, false));
+        physicsComponent()->setLayer(TAG_ENEMY);
+        setRenderCompenent(makePooled<RectRenderComponent>(*this, 0x22, 0xdd, 0x22));
+    }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        GameObject::save(snapshot);
+        snapshot.write(isRunning);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        GameObject::load(reader);
+        reader.read(isRunning);
     }
 };
 
+// build the level from a level file, or the built-in layout if levelPath is
+// null; player is set to the level's player, if it has one
+static std::shared_ptr<Level> buildLevel(const char* levelPath, std::shared_ptr<AvoidPlayer>& player, std::string& error)
+{
+    // the sleep enemies chase the player, which level files make first
+    LevelLoader loader;
+    loader.registerKind("player", [&player](const LevelFile::Object& obj) {
+        player = makePooled<AvoidPlayer>(obj.x, obj.y);
+        return player;
+    });
+    loader.registerKind("goal", [](const LevelFile::Object& obj) { return makePooled<AvoidGoal>(obj.x, obj.y); });
+    loader.registerKind("rush", [](const LevelFile::Object& obj) { return makePooled<RushEnemy>(obj.x, obj.y); });
+    loader.registerKind("sleep", [&player](const LevelFile::Object& obj) { return makePooled<SleepEnemy>(obj.x, obj.y, player); });
+    loader.registerBehavior("wander", [](GameObject& obj) {
+        std::shared_ptr<StateComponent> sc = makePooled<StateComponent>(obj);
+        sc->setStartState(makePooled<WanderState>(3.0f));
+        obj.addGenericCompenent(sc);
+    });
+
+    std::shared_ptr<Level> level;
+    if (levelPath) {
+        level = loader.load(levelPath, error);
+        if (!level) {
+            return nullptr;
+        }
+    } else {
+        level = std::make_shared<Level>(30 * SIZE, 30 * SIZE);
+
+        player = makePooled<AvoidPlayer>(14 * SIZE, 14 * SIZE);
+        level->addObject(player);
+
+        level->addObject(makePooled<AvoidGoal>(9 * SIZE, 9 * SIZE));
+        level->addObject(makePooled<AvoidGoal>(9 * SIZE, 19 * SIZE));
+        level->addObject(makePooled<AvoidGoal>(19 * SIZE, 19 * SIZE));
+        level->addObject(makePooled<AvoidGoal>(19 * SIZE, 9 * SIZE));
+
+        level->addObject(makePooled<AvoidGoal>(4 * SIZE, 14 * SIZE));
+        level->addObject(makePooled<AvoidGoal>(14 * SIZE, 4 * SIZE));
+        level->addObject(makePooled<AvoidGoal>(14 * SIZE, 24 * SIZE));
+        level->addObject(makePooled<AvoidGoal>(24 * SIZE, 14 * SIZE));
+
+        level->addObject(makePooled<RushEnemy>(4 * SIZE, 4 * SIZE));
+        level->addObject(makePooled<RushEnemy>(4 * SIZE, 24 * SIZE));
+        level->addObject(makePooled<RushEnemy>(24 * SIZE, 4 * SIZE));
+        level->addObject(makePooled<RushEnemy>(24 * SIZE, 24 * SIZE));
+
+        level->addObject(makePooled<SleepEnemy>(0 * SIZE, 0 * SIZE, player));
+        level->addObject(makePooled<SleepEnemy>(29 * SIZE, 0 * SIZE, player));
+        level->addObject(makePooled<SleepEnemy>(0 * SIZE, 29 * SIZE, player));
+        level->addObject(makePooled<SleepEnemy>(29 * SIZE, 29 * SIZE, player));
+    }
+
+    if (player) {
+        level->blackboard().setPlayer(player);
+        level->flowField().setTarget(player);
+        level->ai().setFocus(player);
+    }
+    level->influence().addLayer(TAG_ENEMY, 1.0f, SIZE * 6.0f);
+
+    // each kind is on the layer of its tag; only the player's contacts and
+    // being stopped by blocks matter, so enemies and goals ignore each other
+    level->collisionLayers().setCollides(TAG_ENEMY, TAG_ENEMY, false);
+    level->collisionLayers().setCollides(TAG_GOAL, TAG_GOAL, false);
+    level->collisionLayers().setCollides(TAG_ENEMY, TAG_GOAL, false);
+    return level;
+}
+
+// run seeded episodes headless across all cores, with the player wandering
+// at random, and report how long it survived the enemies
+static int runEpisodes(const char* levelPath, unsigned episodes, unsigned threads, unsigned ticks)
+{
+    // the level is seeded by the runner; a level that fails to load fails
+    // every episode, so keep the first error to report
+    std::mutex errorMutex;
+    std::string loadError;
+    WorldRunner::Episode episode;
+    episode.create = [levelPath, &errorMutex, &loadError](unsigned) {
+        std::string error;
+        std::shared_ptr<AvoidPlayer> player;
+        std::shared_ptr<Level> level = buildLevel(levelPath, player, error);
+        if (!level) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (loadError.empty()) {
+                loadError = error;
+            }
+        }
+        return level;
+    };
+    episode.control = [](Level& level, unsigned tick) {
+        // hold a random direction for half a second at a time
+        if (tick % 15 != 0) {
+            return;
+        }
+        int dir = level.random().next(9);
+        InputManager::KeySet down;
+        down[dir % 3 == 0 ? SDL_SCANCODE_LEFT : SDL_SCANCODE_RIGHT] = dir % 3 != 1;
+        down[dir / 3 == 0 ? SDL_SCANCODE_UP : SDL_SCANCODE_DOWN] = dir / 3 != 1;
+        level.input().setKeys(down, InputManager::KeySet());
+    };
+    episode.done = [](const Level& level, float& score) {
+        score = level.time() / 1000.0f;
+        std::shared_ptr<GameObject> player = level.blackboard().getPlayerPtr();
+        return player && !level.hasObject(player);
+    };
+    episode.maxTicks = ticks;
+
+    std::vector<unsigned> seeds(episodes);
+    for (unsigned ii = 0; ii < episodes; ++ii) {
+        seeds[ii] = ii + 1;
+    }
+
+    WorldRunner runner(threads);
+    std::vector<WorldRunner::Result> results;
+    auto start = std::chrono::steady_clock::now();
+    runner.run(episode, seeds, results);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (!loadError.empty()) {
+        std::cerr << loadError << std::endl;
+        return 1;
+    }
+
+    unsigned caught = 0;
+    double survived = 0.0;
+    for (const WorldRunner::Result& result : results) {
+        caught += result.finished;
+        survived += result.score;
+    }
+    std::cout << episodes << " episodes on " << runner.threadCount() << " threads in " << elapsed.count() << " s ("
+              << episodes / elapsed.count() << " per second)" << std::endl;
+    std::cout << "player caught in " << caught << ", survived " << survived / episodes << " s on average" << std::endl;
+    return 0;
+}
+
+// usage: main-avoid [LEVEL] [--speed X|max] [--stats SOCKET] [--ai-budget US] [--record FILE | --replay FILE | --episodes N [--threads N] [--ticks N]]
+//
+// --speed runs the game X times faster than real time (0 pauses), or as
+// fast as possible; --record saves the session's input to FILE on quitting;
+// --replay plays FILE back headless and as fast as possible, then reports the
+// time taken; --episodes runs N seeded episodes headless on all cores (or
+// --threads) for up to --ticks ticks each, and reports the results;
+// --stats serves live statistics on a Unix domain socket while running;
+// --ai-budget thins out the thinking of enemies far from the player and
+// caps it at US microseconds per tick; it depends on how fast the machine
+// runs, so it is for interactive play only and cannot be combined with the
+// deterministic modes
 int main(int argc, char** argv)
 {
-    std::shared_ptr<Level> level = std::make_shared<Level>(30 * SIZE, 30 * SIZE);
+    const char* levelPath = nullptr;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* statsPath = nullptr;
+    int aiBudget = -1;
+    unsigned episodes = 0;
+    unsigned threads = 0;
+    unsigned ticks = 30 * 60;
+    float speed = 1.0f;
+    for (int ii = 1; ii < argc; ++ii) {
+        if (std::strcmp(argv[ii], "--record") == 0 && ii + 1 < argc) {
+            recordPath = argv[++ii];
+        } else if (std::strcmp(argv[ii], "--replay") == 0 && ii + 1 < argc) {
+            replayPath = argv[++ii];
+        } else if (std::strcmp(argv[ii], "--stats") == 0 && ii + 1 < argc) {
+            statsPath = argv[++ii];
+        } else if (std::strcmp(argv[ii], "--ai-budget") == 0 && ii + 1 < argc) {
+            aiBudget = std::max(0, std::atoi(argv[++ii]));
+        } else if (std::strcmp(argv[ii], "--speed") == 0 && ii + 1 < argc) {
+            ++ii;
+            speed = std::strcmp(argv[ii], "max") == 0 ? SimClock::FASTEST : float(std::atof(argv[ii]));
+        } else if (std::strcmp(argv[ii], "--episodes") == 0 && ii + 1 < argc) {
+            episodes = unsigned(std::atoi(argv[++ii]));
+        } else if (std::strcmp(argv[ii], "--threads") == 0 && ii + 1 < argc) {
+            threads = unsigned(std::atoi(argv[++ii]));
+        } else if (std::strcmp(argv[ii], "--ticks") == 0 && ii + 1 < argc) {
+            ticks = unsigned(std::atoi(argv[++ii]));
+        } else if (argv[ii][0] != '-' && !levelPath) {
+            levelPath = argv[ii];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [LEVEL] [--speed X|max] [--stats SOCKET] [--ai-budget US] [--record FILE | --replay FILE | --episodes N [--threads N] [--ticks N]]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (aiBudget >= 0 && (recordPath || replayPath || episodes > 0)) {
+        std::cerr << "--ai-budget depends on timing, so it cannot be used with --record, --replay or --episodes" << std::endl;
+        return 1;
+    }
+
+    std::string error;
+    StatsServer stats;
+    if (statsPath && !stats.start(statsPath, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
 
-    std::shared_ptr<AvoidPlayer> player = std::make_shared<AvoidPlayer>(14 * SIZE, 14 * SIZE);
+    if (episodes > 0) {
+        return runEpisodes(levelPath, episodes, threads, ticks);
+    }
 
-    Blackboard::getInstance()->setPlayer(player);
+    std::shared_ptr<AvoidPlayer> player;
+    std::shared_ptr<Level> level = buildLevel(levelPath, player, error);
+    if (!level) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
 
-    level->addObject(player);
-    level->addObject(std::make_shared<AvoidGoal>(9 * SIZE, 9 * SIZE));
-    level->addObject(std::make_shared<AvoidGoal>(9 * SIZE, 19 * SIZE));
-    level->addObject(std::make_shared<AvoidGoal>(19 * SIZE, 19 * SIZE));
-    level->addObject(std::make_shared<AvoidGoal>(19 * SIZE, 9 * SIZE));
+    if (replayPath) {
+        InputRecording recording;
+        if (!recording.load(replayPath, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
 
-    level->addObject(std::make_shared<AvoidGoal>(4 * SIZE, 14 * SIZE));
-    level->addObject(std::make_shared<AvoidGoal>(14 * SIZE, 4 * SIZE));
-    level->addObject(std::make_shared<AvoidGoal>(14 * SIZE, 24 * SIZE));
-    level->addObject(std::make_shared<AvoidGoal>(24 * SIZE, 14 * SIZE));
+        SDLGraphicsProgram mySDLGraphicsProgram(level, true);
 
-    level->addObject(std::make_shared<RushEnemy>(4 * SIZE, 4 * SIZE));
-    level->addObject(std::make_shared<RushEnemy>(4 * SIZE, 24 * SIZE));
-    level->addObject(std::make_shared<RushEnemy>(24 * SIZE, 4 * SIZE));
-    level->addObject(std::make_shared<RushEnemy>(24 * SIZE, 24 * SIZE));
+        auto start = std::chrono::steady_clock::now();
+        mySDLGraphicsProgram.replay(recording);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
 
-    level->addObject(std::make_shared<SleepEnemy>(0 * SIZE, 0 * SIZE, player));
-    level->addObject(std::make_shared<SleepEnemy>(29 * SIZE, 0 * SIZE, player));
-    level->addObject(std::make_shared<SleepEnemy>(0 * SIZE, 29 * SIZE, player));
-    level->addObject(std::make_shared<SleepEnemy>(29 * SIZE, 29 * SIZE, player));
+        std::cout << "replayed " << recording.frameCount() << " ticks in " << elapsed.count() << " ms" << std::endl;
+        if (player) {
+            std::cout << "player ended at " << player->x() << ", " << player->y() << std::endl;
+        }
+        return 0;
+    }
 
     SDLGraphicsProgram mySDLGraphicsProgram(level);
+    level->clock().setScale(speed);
+    if (aiBudget >= 0) {
+        level->ai().setEnabled(true);
+        level->ai().setBudget(unsigned(aiBudget));
+    }
+
+    InputRecording recording;
+    if (recordPath) {
+        mySDLGraphicsProgram.record(&recording);
+    }
 
     mySDLGraphicsProgram.loop();
 
+    if (recordPath) {
+        if (!recording.save(recordPath, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
     return 0;
 }
@@ -0,0 +1,34 @@
+#include "base/AIComponent.hpp"
+#include "base/AIScheduler.hpp"
+#include "base/Level.hpp"
+
+AIComponent::AIComponent(GameObject& gameObject)
+    : GenericComponent(gameObject)
+    , mScheduler(nullptr)
+    , mSlot(0)
+    , mMaxPeriod(AIScheduler::MAX_PERIOD)
+{
+}
+
+AIComponent::~AIComponent()
+{
+    if (mScheduler) {
+        mScheduler->remove(mSlot);
+    }
+}
+
+void AIComponent::update(Level& level)
+{
+    AIScheduler& scheduler = level.ai();
+    if (!scheduler.enabled()) {
+        scheduler.mElapsed = 1;
+        think(level);
+        return;
+    }
+    if (!scheduler.admit(*this, getGameObject(), level)) {
+        return;
+    }
+    const Uint64 start = SDL_GetPerformanceCounter();
+    think(level);
+    scheduler.spent(*this, SDL_GetPerformanceCounter() - start);
+}
@@ -0,0 +1,37 @@
+#ifndef BASE_AI_COMPONENT
+#define BASE_AI_COMPONENT
+
+#include "base/GenericComponent.hpp"
+#include <cstddef>
+
+class AIScheduler;
+
+//! \brief A generic component whose update is thinking, which the level's
+//! AIScheduler can spread over ticks. Subclasses do their work in think;
+//! update calls it on the ticks the scheduler picks, or every tick when
+//! scheduling is off. A think stands for every tick since the last one, so
+//! work done per tick, such as a step of movement, is scaled by
+//! AIScheduler::elapsed.
+class AIComponent : public GenericComponent {
+public:
+    AIComponent(GameObject& gameObject);
+    virtual ~AIComponent();
+
+    virtual void update(Level& level) override final;
+    virtual void think(Level& level) = 0; //!< Do the component's work for the ticks level.ai().elapsed() gives, at least 1.
+
+    inline unsigned maxPeriod() const { return mMaxPeriod; }
+    //! \brief Let the scheduler leave at most this many ticks between
+    //! thinks, however far the agent is; 1 for agents that must think every
+    //! tick.
+    inline void setMaxPeriod(unsigned period) { mMaxPeriod = period; }
+
+private:
+    friend class AIScheduler;
+
+    AIScheduler* mScheduler; //!< the scheduler this is registered with, if any
+    std::size_t mSlot; //!< index in the scheduler's agents, kept up to date as they move
+    unsigned mMaxPeriod;
+};
+
+#endif
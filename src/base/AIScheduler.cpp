@@ -0,0 +1,197 @@
+#include "base/AIScheduler.hpp"
+#include "base/AIComponent.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include <algorithm>
+
+AIScheduler::AIScheduler()
+    : mAwakeCount(0)
+    , mNear(SIZE * 8.0f)
+    , mBudget(0)
+    , mNextPhase(0)
+    , mElapsed(1)
+    , mTick(0)
+    , mEnabled(false)
+    , mThinks(Stats::global().counter("ai.thinks"))
+    , mDeferred(Stats::global().counter("ai.deferred"))
+{
+}
+
+AIScheduler::~AIScheduler()
+{
+    for (Agent& agent : mAgents) {
+        agent.component->mScheduler = nullptr;
+    }
+}
+
+void AIScheduler::setFocus(std::weak_ptr<GameObject> focus)
+{
+    mFocus = focus;
+}
+
+unsigned AIScheduler::periodOf(const Agent& agent, float focusX, float focusY) const
+{
+    const float dx = agent.owner->x() + agent.owner->w() * 0.5f - focusX;
+    const float dy = agent.owner->y() + agent.owner->h() * 0.5f - focusY;
+    const float distance2 = dx * dx + dy * dy;
+    const float near2 = mNear * mNear;
+
+    unsigned period = 8;
+    if (distance2 < near2) {
+        period = 1;
+    } else if (distance2 < 4.0f * near2) {
+        period = 2;
+    } else if (distance2 < 16.0f * near2) {
+        period = 4;
+    }
+    return std::min(period, std::max(1u, agent.component->maxPeriod()));
+}
+
+void AIScheduler::plan(const Level& level)
+{
+    mTick = level.clock().ticks();
+    if (!mEnabled) {
+        return;
+    }
+
+    std::shared_ptr<GameObject> focus = mFocus.lock();
+    mDue.clear();
+    for (std::uint32_t i = 0; i < mAwakeCount; ++i) {
+        Agent& agent = mAgents[i];
+        agent.period = focus ? periodOf(agent, focus->x() + focus->w() * 0.5f, focus->y() + focus->h() * 0.5f) : 1;
+        agent.run = false;
+
+        // due on its phase, or once a full period has passed, which also
+        // catches up agents deferred or moved to a shorter period
+        const std::uint64_t waited = mTick - agent.lastRun;
+        if (waited >= agent.period || (waited > 0 && (mTick + agent.phase) % agent.period == 0)) {
+            mDue.push_back(i);
+        }
+    }
+
+    if (mBudget == 0) {
+        for (std::uint32_t slot : mDue) {
+            mAgents[slot].run = true;
+        }
+        return;
+    }
+
+    // most overdue first, then the agents that think most often
+    std::sort(mDue.begin(), mDue.end(), [this](std::uint32_t a, std::uint32_t b) {
+        const Agent& agentA = mAgents[a];
+        const Agent& agentB = mAgents[b];
+        const std::int64_t lateA = std::int64_t(mTick - agentA.lastRun) - agentA.period;
+        const std::int64_t lateB = std::int64_t(mTick - agentB.lastRun) - agentB.period;
+        if (lateA != lateB) {
+            return lateA > lateB;
+        }
+        return agentA.period != agentB.period ? agentA.period < agentB.period : a < b;
+    });
+    float planned = 0.0f;
+    for (std::size_t k = 0; k < mDue.size(); ++k) {
+        Agent& agent = mAgents[mDue[k]];
+        planned += std::max(agent.cost, 0.0f);
+        if (k > 0 && planned > float(mBudget)) {
+            mDeferred.add(mDue.size() - k);
+            break;
+        }
+        agent.run = true;
+    }
+}
+
+bool AIScheduler::admit(AIComponent& component, const GameObject& owner, const Level& level)
+{
+    if (component.mScheduler != this) {
+        // new, or moved from another level; it thinks at once to join
+        if (component.mScheduler) {
+            component.mScheduler->remove(component.mSlot);
+        }
+        component.mScheduler = this;
+        component.mSlot = mAgents.size();
+        mAgents.push_back({ &component, &owner, mTick, mNextPhase++ % MAX_PERIOD, 1, -1.0f, true });
+        mByOwner.insert(std::make_pair(&owner, &component));
+        // its object is updating, so awake
+        swapAgents(component.mSlot, mAwakeCount++);
+        mElapsed = 1;
+        mThinks.add();
+        return true;
+    }
+
+    Agent& agent = mAgents[component.mSlot];
+    if (!agent.run) {
+        return false;
+    }
+    // ticks its object slept through are not owed
+    mElapsed = unsigned(std::clamp<std::uint64_t>(mTick - agent.lastRun, 1, MAX_PERIOD));
+    agent.lastRun = mTick;
+    mThinks.add();
+    return true;
+}
+
+void AIScheduler::spent(AIComponent& component, std::uint64_t counts)
+{
+    Agent& agent = mAgents[component.mSlot];
+    const float micros = float(double(counts) * 1000000.0 / double(SDL_GetPerformanceFrequency()));
+    agent.cost = agent.cost < 0.0f ? micros : agent.cost + (micros - agent.cost) * 0.125f;
+}
+
+void AIScheduler::remove(const GameObject& owner)
+{
+    for (auto found = mByOwner.find(&owner); found != mByOwner.end(); found = mByOwner.find(&owner)) {
+        remove(found->second->mSlot);
+    }
+}
+
+void AIScheduler::wake(const GameObject& owner)
+{
+    auto range = mByOwner.equal_range(&owner);
+    for (auto ii = range.first; ii != range.second; ++ii) {
+        if (ii->second->mSlot >= mAwakeCount) {
+            swapAgents(ii->second->mSlot, mAwakeCount++);
+        }
+    }
+}
+
+void AIScheduler::sleep(const GameObject& owner)
+{
+    auto range = mByOwner.equal_range(&owner);
+    for (auto ii = range.first; ii != range.second; ++ii) {
+        if (ii->second->mSlot < mAwakeCount) {
+            swapAgents(ii->second->mSlot, --mAwakeCount);
+        }
+    }
+}
+
+void AIScheduler::wakeAll()
+{
+    mAwakeCount = mAgents.size();
+}
+
+void AIScheduler::remove(std::size_t slot)
+{
+    Agent& agent = mAgents[slot];
+    auto range = mByOwner.equal_range(agent.owner);
+    for (auto ii = range.first; ii != range.second; ++ii) {
+        if (ii->second == agent.component) {
+            mByOwner.erase(ii);
+            break;
+        }
+    }
+    agent.component->mScheduler = nullptr;
+    if (slot < mAwakeCount) {
+        swapAgents(slot, --mAwakeCount);
+        slot = mAwakeCount;
+    }
+    swapAgents(slot, mAgents.size() - 1);
+    mAgents.pop_back();
+}
+
+void AIScheduler::swapAgents(std::size_t a, std::size_t b)
+{
+    if (a == b) {
+        return;
+    }
+    std::swap(mAgents[a], mAgents[b]);
+    mAgents[a].component->mSlot = a;
+    mAgents[b].component->mSlot = b;
+}
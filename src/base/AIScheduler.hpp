@@ -0,0 +1,101 @@
+#ifndef BASE_AI_SCHEDULER
+#define BASE_AI_SCHEDULER
+
+#include "base/Stats.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class AIComponent;
+class GameObject;
+class Level;
+
+//! \brief Decides which AI components think each tick, so agents far from
+//! what matters cost less and a tick's AI work stays within a budget.
+//!
+//! Each agent gets a period by its distance from a focus object (usually
+//! the player): every tick within the near distance, every 2 ticks within
+//! twice it, every 4 within four times it and every 8 beyond. An agent can
+//! cap its own period. Agents on the same period think on different ticks,
+//! by a phase given to each as it registers, so their work is spread
+//! evenly. With a budget, the agents due in a tick are taken most overdue
+//! first, by what they cost on average, until the budget is spent; the rest
+//! are deferred to the next tick, ahead of agents that are merely due. At
+//! least one agent always thinks, so nothing waits forever. Agents whose
+//! objects sleep are kept apart, so planning a tick costs in proportion to
+//! the awake agents.
+//!
+//! Scheduling is off by default, and then every agent thinks every tick.
+//! Which ticks an agent thinks on is not saved in snapshots, and a budget
+//! depends on how fast the machine runs, so replays and batch runs that
+//! must be reproducible leave it off or use no budget.
+class AIScheduler {
+public:
+    static const unsigned MAX_PERIOD = 8;
+
+    AIScheduler();
+    ~AIScheduler();
+
+    inline bool enabled() const { return mEnabled; }
+    inline void setEnabled(bool enabled) { mEnabled = enabled; }
+
+    void setFocus(std::weak_ptr<GameObject> focus); //!< Set the object distances are measured from; without one every agent is near.
+    inline void setNearDistance(float distance) { mNear = distance; } //!< Set how close agents think every tick.
+    inline void setBudget(unsigned micros) { mBudget = micros; } //!< Set the microseconds of thinking allowed per tick; 0 for no limit.
+
+    inline std::size_t agentCount() const { return mAgents.size(); }
+
+    //! \brief Get how many ticks the think in progress stands for: those
+    //! since the agent last thought, at most MAX_PERIOD so an agent whose
+    //! object slept is not owed the ticks it slept, and 1 when scheduling is
+    //! off. Movement and other per-tick work done in a think is scaled by it.
+    inline unsigned elapsed() const { return mElapsed; }
+
+    void plan(const Level& level); //!< Pick the agents to think this tick; called by the level before objects update.
+    void remove(const GameObject& owner); //!< Drop the agents of an object leaving the level.
+    void wake(const GameObject& owner); //!< Plan for an object's agents again, as it joins the level's awake set.
+    void sleep(const GameObject& owner); //!< Stop planning for an object's agents while it sleeps.
+    void wakeAll(); //!< Plan for every agent, as every object wakes on a restore.
+
+private:
+    AIScheduler(const AIScheduler&) = delete;
+    void operator=(AIScheduler const&) = delete;
+
+    friend class AIComponent;
+
+    //! \brief A registered component and how it has been scheduled.
+    struct Agent {
+        AIComponent* component;
+        const GameObject* owner;
+        std::uint64_t lastRun; //!< tick it last thought
+        unsigned phase;
+        unsigned period; //!< ticks between thinks, as of the last plan
+        float cost; //!< average microseconds per think
+        bool run; //!< if it thinks this tick
+    };
+
+    bool admit(AIComponent& component, const GameObject& owner, const Level& level); //!< Get if a component should think now, registering it if new.
+    void spent(AIComponent& component, std::uint64_t counts); //!< Record what a think took, in performance counter counts.
+    void remove(std::size_t slot);
+    void swapAgents(std::size_t a, std::size_t b); //!< Exchange two slots, keeping the components' slots up to date.
+    unsigned periodOf(const Agent& agent, float focusX, float focusY) const;
+
+    std::vector<Agent> mAgents; //!< agents of awake objects first, then those sleeping
+    std::size_t mAwakeCount; //!< agents of awake objects, the ones plan looks at
+    std::unordered_multimap<const GameObject*, AIComponent*> mByOwner; //!< agents of each owner
+    std::vector<std::uint32_t> mDue; //!< scratch for plan: slots of the agents due
+    std::weak_ptr<GameObject> mFocus;
+    float mNear;
+    unsigned mBudget;
+    unsigned mNextPhase;
+    unsigned mElapsed; //!< ticks the current think stands for
+    std::uint64_t mTick;
+    bool mEnabled;
+
+    StatCounter& mThinks;
+    StatCounter& mDeferred;
+};
+
+#endif
@@ -1,49 +1,16 @@
 #ifndef __BEHAVIOR_TREE_HPP__
 #define __BEHAVIOR_TREE_HPP__
 
-#include "base/GenericComponent.hpp"
+#include "base/AIComponent.hpp"
+#include "base/Blackboard.hpp"
+#include "base/Level.hpp"
+#include "base/Memory.hpp"
+#include "base/Snapshot.hpp"
 
 #include <memory>
 #include <stdlib.h>
 #include <vector>
 
-class Blackboard {
-private:
-    Blackboard() = default;
-    ~Blackboard() = default;
-    Blackboard(const Blackboard&) = delete;
-    void operator=(const Blackboard&) = delete;
-    Blackboard(Blackboard&&) = delete;
-    void operator=(Blackboard&&) = delete;
-
-public:
-    static Blackboard* getInstance()
-    {
-        static Blackboard* instance = new Blackboard();
-        return instance;
-    }
-
-    void setPlayer(std::shared_ptr<GameObject> player)
-    {
-        mPlayerPtr = player;
-    }
-
-    std::shared_ptr<GameObject> getPlayerPtr() const { return mPlayerPtr; }
-
-    void setRushXY(int x, int y)
-    {
-        mRushX = x;
-        mRushY = y;
-    }
-
-    float getRushX() const { return mRushX; }
-    float getRushY() const { return mRushY; }
-
-private:
-    std::shared_ptr<GameObject> mPlayerPtr = nullptr;
-    float mRushX, mRushY;
-};
-
 enum class Status {
     INVALID,
     SUCCESS,
@@ -57,19 +24,42 @@ private:
     Status mStatus;
 
 public:
+    static constexpr Memory::Category MEMORY_CATEGORY = Memory::AI; //!< what makePooled charges nodes to
+
     virtual void onEnter() { }
     virtual void onExit() { }
 
     BehaviorNode()
         : mStatus(Status::INVALID)
+        , mBlackboard(nullptr)
+        , mLevel(nullptr)
+        , mOwner(nullptr)
     {
-        mBlackboard = Blackboard::getInstance();
     }
     virtual ~BehaviorNode() { }
 
     virtual Status update() = 0;
     // virtual Status update(GameObject& gameObject, Level& level) = 0;
 
+    // bind the node, and its children, to the level its tree runs in, that
+    // level's blackboard and the object the tree belongs to
+    virtual void attach(Level& level, GameObject& owner)
+    {
+        mLevel = &level;
+        mBlackboard = &level.blackboard();
+        mOwner = &owner;
+    }
+
+    // if the node is running but waiting on something outside the tree, so
+    // ticking it would change nothing; nodes that can wait, and nodes that
+    // pass ticks on to running children, extend this
+    virtual bool parked() const { return false; }
+
+    // write the node's state, and its children's, to a snapshot; nodes with
+    // state of their own (cursors, timers) extend these
+    virtual void save(Snapshot& snapshot) const { snapshot.write(mStatus); }
+    virtual void load(SnapshotReader& reader) { reader.read(mStatus); }
+
     virtual Status tick()
     {
         if (mStatus != Status::RUNNING)
@@ -94,6 +84,8 @@ public:
     }
 
     Blackboard* mBlackboard;
+    Level* mLevel;
+    GameObject* mOwner;
 };
 
 // ActionNode: accessing information and making changes to the world
@@ -110,6 +102,26 @@ public:
         : mChild(child)
     {
     }
+
+    virtual void attach(Level& level, GameObject& owner) override
+    {
+        BehaviorNode::attach(level, owner);
+        mChild->attach(level, owner);
+    }
+
+    virtual bool parked() const override { return isRunning() && mChild->parked(); }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        BehaviorNode::save(snapshot);
+        mChild->save(snapshot);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        BehaviorNode::load(reader);
+        mChild->load(reader);
+    }
 };
 
 class Inverter : public Decorator {
@@ -139,6 +151,8 @@ protected:
 public:
     Repeater(std::shared_ptr<BehaviorNode> child)
         : Decorator(child)
+        , mCount(0)
+        , mLimit(0)
     {
     }
 
@@ -163,6 +177,18 @@ public:
     }
 
     void setLimit(int limit) { mLimit = limit; }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        Decorator::save(snapshot);
+        snapshot.write(mCount);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        Decorator::load(reader);
+        reader.read(mCount);
+    }
 };
 
 class RepeatUntilFailure : public Decorator {
@@ -190,9 +216,33 @@ protected:
 public:
     void addChild(std::shared_ptr<BehaviorNode> child)
     {
+        MemoryScope scope(Memory::AI);
         mChildren.push_back(child);
+        if (mLevel)
+            child->attach(*mLevel, *mOwner);
     }
     void removeChild(std::shared_ptr<BehaviorNode> child);
+
+    virtual void attach(Level& level, GameObject& owner) override
+    {
+        BehaviorNode::attach(level, owner);
+        for (auto child : mChildren)
+            child->attach(level, owner);
+    }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        BehaviorNode::save(snapshot);
+        for (auto& child : mChildren)
+            child->save(snapshot);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        BehaviorNode::load(reader);
+        for (auto& child : mChildren)
+            child->load(reader);
+    }
 };
 
 // And
@@ -220,6 +270,24 @@ public:
         }
     }
 
+    virtual bool parked() const override { return isRunning() && (*mCurrentChild)->parked(); }
+
+    // the cursor only means something while running; onEnter resets it otherwise
+    virtual void save(Snapshot& snapshot) const override
+    {
+        Composite::save(snapshot);
+        snapshot.write(isRunning() ? int(mCurrentChild - mChildren.begin()) : -1);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        Composite::load(reader);
+        int current;
+        reader.read(current);
+        if (current >= 0)
+            mCurrentChild = mChildren.begin() + current;
+    }
+
     virtual ~Sequence() { }
 };
 
@@ -228,11 +296,13 @@ public:
     void addCondition(std::shared_ptr<BehaviorNode> condition)
     {
         mChildren.insert(mChildren.begin(), condition);
+        if (mLevel)
+            condition->attach(*mLevel, *mOwner);
     }
 
     void addBehavior(std::shared_ptr<BehaviorNode> behavior)
     {
-        mChildren.push_back(behavior);
+        addChild(behavior);
     }
 };
 
@@ -265,6 +335,24 @@ public:
         }
     }
 
+    virtual bool parked() const override { return isRunning() && (*mCurrentChild)->parked(); }
+
+    // the cursor only means something while running; onEnter resets it otherwise
+    virtual void save(Snapshot& snapshot) const override
+    {
+        Composite::save(snapshot);
+        snapshot.write(isRunning() ? int(mCurrentChild - mChildren.begin()) : -1);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        Composite::load(reader);
+        int current;
+        reader.read(current);
+        if (current >= 0)
+            mCurrentChild = mChildren.begin() + current;
+    }
+
     virtual ~Selector() { }
 };
 
@@ -273,9 +361,12 @@ public:
     Status update() override
     {
         std::vector<std::shared_ptr<BehaviorNode>>::iterator currentChild = mChildren.begin();
-        std::advance(currentChild, rand() % mChildren.size());
+        std::advance(currentChild, mLevel->random().next(int(mChildren.size())));
         return (*currentChild)->tick();
     }
+
+    // picks a child afresh each tick
+    virtual bool parked() const override { return false; }
 };
 
 class ActiveSelector : public Selector {
@@ -297,6 +388,16 @@ public:
 
     virtual ~Parallel() { }
 
+    virtual bool parked() const override
+    {
+        if (!isRunning())
+            return false;
+        for (auto& child : mChildren)
+            if (!child->isExit() && !child->parked())
+                return false;
+        return true;
+    }
+
 protected:
     Policy mSuccessPolicy;
     Policy mFailurePolicy;
@@ -338,31 +439,64 @@ protected:
             if (child->isRunning())
                 child->abort();
     }
+
 };
 
 class Monitor : public Parallel {
     // TODO:
 };
 
-class BehaviorTree : public GenericComponent {
+class BehaviorTree : public AIComponent {
 public:
     BehaviorTree(GameObject& gameObject)
-        : GenericComponent(gameObject)
+        : AIComponent(gameObject)
+        , mLevel(nullptr)
     {
     }
     // TODO: cooldown, status check, reset, pass the GameObject to the nodes?
-    virtual void update(Level& level) override
+    // nodes doing per-tick work scale it by level.ai().elapsed()
+    virtual void think(Level& level) override
     {
         if (mRoot == nullptr)
             return;
 
+        if (mLevel != &level) {
+            mRoot->attach(level, getGameObject());
+            mLevel = &level;
+        }
+
+        level.countBehaviorTick();
         mRoot->tick();
     }
 
-    void setRoot(std::shared_ptr<BehaviorNode> root) { mRoot = root; }
+    // while the running leaf waits on a coroutine, ticking the tree changes
+    // nothing; the wait wakes the object when it is over
+    virtual bool canSleep() const override
+    {
+        return !mRoot || mRoot->parked();
+    }
+
+    void setRoot(std::shared_ptr<BehaviorNode> root)
+    {
+        mRoot = root;
+        mLevel = nullptr;
+    }
+
+    virtual void save(Snapshot& snapshot) const override
+    {
+        if (mRoot)
+            mRoot->save(snapshot);
+    }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        if (mRoot)
+            mRoot->load(reader);
+    }
 
 private:
     std::shared_ptr<BehaviorNode> mRoot;
+    Level* mLevel; //!< the level mRoot is attached to
 };
 
 #endif
\ No newline at end of file
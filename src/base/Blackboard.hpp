@@ -0,0 +1,54 @@
+#ifndef BASE_BLACKBOARD
+#define BASE_BLACKBOARD
+
+#include "base/Snapshot.hpp"
+#include <memory>
+
+class GameObject;
+
+//! \brief Data shared by the AI of one level. Each level owns one, and
+//! behavior nodes reach it through the level they are attached to.
+class Blackboard {
+private:
+    Blackboard(const Blackboard&) = delete;
+    void operator=(const Blackboard&) = delete;
+    Blackboard(Blackboard&&) = delete;
+    void operator=(Blackboard&&) = delete;
+
+public:
+    Blackboard() = default;
+
+    void setPlayer(std::shared_ptr<GameObject> player)
+    {
+        mPlayerPtr = player;
+    }
+
+    std::shared_ptr<GameObject> getPlayerPtr() const { return mPlayerPtr; }
+
+    void setRushXY(int x, int y)
+    {
+        mRushX = x;
+        mRushY = y;
+    }
+
+    float getRushX() const { return mRushX; }
+    float getRushY() const { return mRushY; }
+
+    void save(Snapshot& snapshot) const
+    {
+        snapshot.write(mRushX);
+        snapshot.write(mRushY);
+    }
+
+    void load(SnapshotReader& reader)
+    {
+        reader.read(mRushX);
+        reader.read(mRushY);
+    }
+
+private:
+    std::shared_ptr<GameObject> mPlayerPtr = nullptr;
+    float mRushX = 0.0f, mRushY = 0.0f;
+};
+
+#endif
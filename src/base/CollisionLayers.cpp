@@ -0,0 +1,29 @@
+#include "base/CollisionLayers.hpp"
+
+CollisionLayers::CollisionLayers()
+{
+    for (std::uint32_t& mask : mMasks) {
+        mask = ~std::uint32_t(0);
+    }
+}
+
+void CollisionLayers::setCollides(unsigned a, unsigned b, bool collides)
+{
+    if (a >= LAYERS || b >= LAYERS) {
+        return;
+    }
+    if (collides) {
+        mMasks[a] |= std::uint32_t(1) << b;
+        mMasks[b] |= std::uint32_t(1) << a;
+    } else {
+        mMasks[a] &= ~(std::uint32_t(1) << b);
+        mMasks[b] &= ~(std::uint32_t(1) << a);
+    }
+}
+
+void CollisionLayers::setCollidesWithAll(unsigned layer, bool collides)
+{
+    for (unsigned other = 0; other < LAYERS; ++other) {
+        setCollides(layer, other, collides);
+    }
+}
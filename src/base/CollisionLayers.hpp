@@ -0,0 +1,29 @@
+#ifndef BASE_COLLISION_LAYERS
+#define BASE_COLLISION_LAYERS
+
+#include <cstdint>
+
+//! \brief Which collision layers interact, as a symmetric matrix of layer
+//! pairs. Each physics body is on one layer (0 unless set) and only touches
+//! bodies on layers its own layer interacts with; every pair interacts
+//! until told otherwise. A row of the matrix is a bit mask, so the physics
+//! step rejects a pair with two bit tests, before testing any rectangles.
+class CollisionLayers {
+public:
+    static const unsigned LAYERS = 32;
+
+    CollisionLayers();
+
+    //! \brief Set if bodies on layers a and b touch each other, which goes
+    //! both ways. Layers out of range are ignored.
+    void setCollides(unsigned a, unsigned b, bool collides);
+    void setCollidesWithAll(unsigned layer, bool collides); //!< Set if bodies on a layer touch bodies on any layer, its own included.
+
+    inline bool collides(unsigned a, unsigned b) const { return (mMasks[a] >> b) & 1u; }
+    inline std::uint32_t mask(unsigned layer) const { return mMasks[layer]; } //!< Get the layers a layer interacts with, one bit each.
+
+private:
+    std::uint32_t mMasks[LAYERS];
+};
+
+#endif
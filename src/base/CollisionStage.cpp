@@ -0,0 +1,350 @@
+#include "base/CollisionStage.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+CollisionStage::CollisionStage()
+    : mRestingWidth(0)
+    , mRestingVersion(~std::uint64_t(0))
+{
+}
+
+void CollisionStage::step(Level& level, const std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    mBodies.clear();
+    mBodyOf.resize(objects.size());
+    for (std::uint32_t i : level.awakeObjects()) {
+        GameObject& obj = *objects[i];
+        const PhysicsComponent* physics = std::as_const(obj).physicsComponent();
+        if (!physics) {
+            continue;
+        }
+        mBodyOf[i] = std::uint32_t(mBodies.size());
+        mBodies.push_back(makeBody(obj, i, *physics));
+        obj.step(level);
+    }
+
+    // rebuild when indices changed or over half the entries are stale
+    const std::size_t resting = level.sleepingObjects().size() + level.staticObjects().size();
+    if (mRestingVersion != level.partitionVersion() || mResting.size() > 2 * resting + 64) {
+        sortResting(level, objects);
+    } else {
+        addResting(level.restedObjects(), objects);
+    }
+    mContactCache.begin(level);
+    gather(objects);
+    resolve();
+    dispatch(level, objects);
+    mContactCache.end();
+    dispatchEnded(level);
+}
+
+void CollisionStage::prepare(const Level& level, const std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    sortResting(level, objects);
+}
+
+bool CollisionStage::restingOrder(const Resting& a, const Resting& b)
+{
+    return a.x0 != b.x0 ? a.x0 < b.x0 : a.index < b.index;
+}
+
+void CollisionStage::sortResting(const Level& level, const std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    mResting.clear();
+    mRestingWidth = 0;
+    for (const std::vector<std::uint32_t>* set : { &level.sleepingObjects(), &level.staticObjects() }) {
+        for (std::uint32_t i : *set) {
+            const GameObject& obj = *objects[i];
+            if (!obj.physicsComponent()) {
+                continue;
+            }
+            const int x0 = int(obj.x());
+            const int x1 = x0 + int(obj.w());
+            mResting.push_back({ &obj, i, x0, x1 });
+            mRestingWidth = std::max(mRestingWidth, x1 - x0);
+        }
+    }
+    std::sort(mResting.begin(), mResting.end(), restingOrder);
+    mRestingVersion = level.partitionVersion();
+}
+
+void CollisionStage::addResting(const std::vector<std::uint32_t>& indices, const std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    // new entries go on the end, sorted and merged in at once, so many
+    // objects coming to rest together cost a sort rather than an insert each
+    const std::size_t sorted = mResting.size();
+    for (std::uint32_t i : indices) {
+        // an index can go stale when removals move objects again
+        if (i >= objects.size()) {
+            continue;
+        }
+        const GameObject& obj = *objects[i];
+        if (!obj.physicsComponent() || obj.activity() == GameObject::AWAKE) {
+            continue;
+        }
+        // an object back at rest where it rested before still has its entry
+        const int x0 = int(obj.x());
+        const Resting entry = { &obj, i, x0, x0 + int(obj.w()) };
+        auto at = std::lower_bound(mResting.begin(), mResting.begin() + sorted, entry, restingOrder);
+        if (at == mResting.begin() + sorted || at->x0 != entry.x0 || at->index != i || at->object != &obj) {
+            mResting.push_back(entry);
+            mRestingWidth = std::max(mRestingWidth, entry.x1 - entry.x0);
+        }
+    }
+    if (mResting.size() == sorted) {
+        return;
+    }
+    std::sort(mResting.begin() + sorted, mResting.end(), restingOrder);
+    // an index rested twice since the last step is added once
+    auto same = [](const Resting& a, const Resting& b) { return a.x0 == b.x0 && a.index == b.index && a.object == b.object; };
+    mResting.erase(std::unique(mResting.begin() + sorted, mResting.end(), same), mResting.end());
+    std::inplace_merge(mResting.begin(), mResting.begin() + sorted, mResting.end(), restingOrder);
+}
+
+bool CollisionStage::isResting(const Resting& resting, const std::vector<std::shared_ptr<GameObject>>& objects) const
+{
+    if (resting.index >= objects.size() || objects[resting.index].get() != resting.object) {
+        return false;
+    }
+    const GameObject& obj = *resting.object;
+    return obj.activity() != GameObject::AWAKE && int(obj.x()) == resting.x0;
+}
+
+bool CollisionStage::sweep(const Box& moving, float dx, float dy, const Box& still, float& time, bool& xAxis)
+{
+    // the times the box starts and stops overlapping the still one along an axis
+    auto slab = [](float a0, float a1, float b0, float b1, float d, float& enter, float& exit) {
+        if (d == 0.0f) {
+            enter = -INFINITY;
+            exit = INFINITY;
+            return a0 < b1 && b0 < a1;
+        }
+        enter = (d > 0.0f ? b0 - a1 : b1 - a0) / d;
+        exit = (d > 0.0f ? b1 - a0 : b0 - a1) / d;
+        return true;
+    };
+
+    float enterX, exitX, enterY, exitY;
+    if (!slab(moving.x, moving.x + moving.w, still.x, still.x + still.w, dx, enterX, exitX)
+        || !slab(moving.y, moving.y + moving.h, still.y, still.y + still.h, dy, enterY, exitY)) {
+        return false;
+    }
+    const float enter = std::max(enterX, enterY);
+    const float exit = std::min(exitX, exitY);
+    if (enter >= exit || enter < 0.0f || enter > 1.0f) {
+        return false;
+    }
+    time = enter;
+    xAxis = enterX >= enterY;
+    return true;
+}
+
+CollisionStage::Body CollisionStage::makeBody(GameObject& obj, std::uint32_t index, const PhysicsComponent& physics) const
+{
+    const int x0 = int(obj.x());
+    return { &obj, index, x0, x0 + int(obj.w()), obj.x(), obj.y(), std::uint32_t(1) << physics.layer(),
+        physics.mask() & mLayers.mask(physics.layer()), physics.isSolid() };
+}
+
+bool CollisionStage::interacts(const Body& a, const Body& b)
+{
+    return !(a.solid && b.solid) && (a.mask & b.layer) && (b.mask & a.layer);
+}
+
+bool CollisionStage::touched(const Body& a, const Body& b) const
+{
+    if (a.object->isColliding(*b.object)) {
+        return true;
+    }
+    // sweep a against b, both at their starting positions, by their relative motion
+    const Box boxA = { a.oldX, a.oldY, a.object->w(), a.object->h() };
+    const Box boxB = { b.oldX, b.oldY, b.object->w(), b.object->h() };
+    const float dx = (a.object->x() - a.oldX) - (b.object->x() - b.oldX);
+    const float dy = (a.object->y() - a.oldY) - (b.object->y() - b.oldY);
+    float time;
+    bool xAxis;
+    return sweep(boxA, dx, dy, boxB, time, xAxis);
+}
+
+static std::uint64_t tagPair(int a, int b)
+{
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return std::uint64_t(std::uint32_t(a) ^ 0x80000000u) << 32 | (std::uint32_t(b) ^ 0x80000000u);
+}
+
+std::uint32_t CollisionStage::cachedEntry(const Body& a, const Body& b) const
+{
+    // only contacts handed to components are cached, and a pair that has
+    // not moved since it overlapped still overlaps, so the table is only
+    // looked in for boxes overlapping now, give or take rounding
+    const GameObject& objA = *a.object;
+    const GameObject& objB = *b.object;
+    if (a.solid || b.solid || mContactCache.size() == 0
+        || objA.x() > objB.x() + objB.w() + 1.0f || objB.x() > objA.x() + objA.w() + 1.0f
+        || objA.y() > objB.y() + objB.h() + 1.0f || objB.y() > objA.y() + objA.h() + 1.0f) {
+        return ContactCache::NONE;
+    }
+    return mContactCache.findUnchanged(std::min(a.index, b.index), std::max(a.index, b.index));
+}
+
+void CollisionStage::addContact(const Body& a, const Body& b, std::uint32_t cached)
+{
+    const std::uint64_t tags = tagPair(a.object->tag(), b.object->tag());
+    if (a.solid || b.solid) {
+        const Body& mover = a.solid ? b : a;
+        const Body& solid = a.solid ? a : b;
+        mContacts.push_back({ tags, mover.index, solid.index, true, ContactCache::NONE });
+    } else {
+        mContacts.push_back({ tags, std::min(a.index, b.index), std::max(a.index, b.index), false, cached });
+    }
+}
+
+void CollisionStage::keepResting(const Body& body)
+{
+    // mBodyOf may be left over from an earlier tick, so check it points back
+    const std::uint32_t awake = std::uint32_t(mBodies.size());
+    const std::uint32_t kept = mBodyOf[body.index] - awake;
+    if (mBodyOf[body.index] >= awake && kept < mRestingBodies.size() && mRestingBodies[kept].index == body.index) {
+        return;
+    }
+    mBodyOf[body.index] = awake + std::uint32_t(mRestingBodies.size());
+    mRestingBodies.push_back(body);
+}
+
+void CollisionStage::gather(const std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    for (Body& body : mBodies) {
+        const int from = int(body.oldX);
+        const int to = int(body.object->x());
+        body.x0 = std::min(from, to);
+        body.x1 = std::max(from, to) + int(body.object->w());
+    }
+    std::sort(mBodies.begin(), mBodies.end(), [](const Body& a, const Body& b) { return a.x0 < b.x0; });
+    for (std::uint32_t i = 0; i < mBodies.size(); ++i) {
+        mBodyOf[mBodies[i].index] = i;
+    }
+
+    mContacts.clear();
+    for (std::size_t i = 0; i < mBodies.size(); ++i) {
+        const Body& bi = mBodies[i];
+        for (std::size_t j = i + 1; j < mBodies.size() && mBodies[j].x0 < bi.x1; ++j) {
+            const Body& bj = mBodies[j];
+            if (!interacts(bi, bj)) {
+                continue;
+            }
+            const std::uint32_t cached = cachedEntry(bi, bj);
+            if (cached == ContactCache::NONE && !touched(bi, bj)) {
+                continue;
+            }
+            addContact(bi, bj, cached);
+        }
+    }
+
+    // each awake body against the objects at rest its extent reaches
+    mRestingBodies.clear();
+    for (const Body& body : mBodies) {
+        auto first = std::lower_bound(mResting.begin(), mResting.end(), body.x0 - mRestingWidth,
+            [](const Resting& resting, int x) { return resting.x0 < x; });
+        for (auto it = first; it != mResting.end() && it->x0 < body.x1; ++it) {
+            if (it->x1 <= body.x0 || !isResting(*it, objects)) {
+                continue;
+            }
+            GameObject& obj = *objects[it->index];
+            const Body rest = makeBody(obj, it->index, *std::as_const(obj).physicsComponent());
+            if (!interacts(body, rest)) {
+                continue;
+            }
+            const std::uint32_t cached = cachedEntry(body, rest);
+            if (cached == ContactCache::NONE && !touched(body, rest)) {
+                continue;
+            }
+            keepResting(rest);
+            addContact(body, rest, cached);
+        }
+    }
+    mBodies.insert(mBodies.end(), mRestingBodies.begin(), mRestingBodies.end());
+
+    // level order within a tag pair, so results do not depend on how the sweep met the pairs
+    std::sort(mContacts.begin(), mContacts.end(), [](const Contact& a, const Contact& b) {
+        if (a.tags != b.tags) {
+            return a.tags < b.tags;
+        }
+        return a.a != b.a ? a.a < b.a : a.b < b.b;
+    });
+}
+
+void CollisionStage::resolve()
+{
+    for (const Contact& contact : mContacts) {
+        if (!contact.solid) {
+            continue;
+        }
+        const Body& mover = mBodies[mBodyOf[contact.a]];
+        const Body& solid = mBodies[mBodyOf[contact.b]];
+        mover.object->physicsComponent()->resolve(*solid.object, mover.oldX, mover.oldY);
+    }
+}
+
+void CollisionStage::dispatch(Level& level, const std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    // contacts resolution pushed apart no longer count; a cached pair that
+    // has not moved since it overlapped needs no test, nor, if gathering
+    // found it so, looking up again
+    mEvents.clear();
+    for (std::uint32_t i = 0; i < mContacts.size(); ++i) {
+        const Contact& contact = mContacts[i];
+        if (contact.solid) {
+            continue;
+        }
+        ContactCache::Entry* entry = contact.cached != ContactCache::NONE ? &mContactCache.mEntries[contact.cached] : nullptr;
+        if (!(entry && mContactCache.unchanged(*entry))) {
+            entry = mContactCache.find(contact.a, contact.b);
+            if (!(entry && mContactCache.unchanged(*entry)) && !touched(mBodies[mBodyOf[contact.a]], mBodies[mBodyOf[contact.b]])) {
+                continue;
+            }
+        }
+        const bool began = mContactCache.touch(entry, contact.a, contact.b, objects);
+        mEvents.push_back({ contact.a, contact.b, i, began });
+        mEvents.push_back({ contact.b, contact.a, i, began });
+    }
+    std::sort(mEvents.begin(), mEvents.end(), [](const Event& a, const Event& b) {
+        return a.receiver != b.receiver ? a.receiver < b.receiver : a.order < b.order;
+    });
+
+    for (std::size_t i = 0; i < mEvents.size();) {
+        const std::uint32_t receiver = mEvents[i].receiver;
+        const std::size_t first = i;
+        mGroup.clear();
+        for (; i < mEvents.size() && mEvents[i].receiver == receiver; ++i) {
+            mGroup.push_back(objects[mEvents[i].other]);
+        }
+        GameObject& obj = *objects[receiver];
+        obj.collisions(level, mGroup);
+        for (std::size_t k = first; k < i; ++k) {
+            if (mEvents[k].began) {
+                obj.collisionBegin(level, mGroup[k - first]);
+            } else {
+                obj.collisionPersist(level, mGroup[k - first]);
+            }
+        }
+    }
+    mGroup.clear();
+}
+
+void CollisionStage::dispatchEnded(Level& level)
+{
+    for (ContactCache::Ended& ended : mContactCache.mEnded) {
+        if (level.hasObject(ended.a)) {
+            ended.a->collisionEnd(level, ended.b);
+        }
+        if (level.hasObject(ended.b)) {
+            ended.b->collisionEnd(level, ended.a);
+        }
+    }
+    mContactCache.mEnded.clear();
+}
@@ -0,0 +1,147 @@
+#ifndef BASE_COLLISION_STAGE
+#define BASE_COLLISION_STAGE
+
+#include "base/CollisionLayers.hpp"
+#include "base/ContactCache.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GameObject;
+class Level;
+class PhysicsComponent;
+class SnapshotReader;
+
+//! \brief The physics step of a level, run once per tick after objects
+//! update. Every object with a physics component moves by its velocity;
+//! then all contact pairs of the tick are gathered into one array with a
+//! sort and sweep along x, sorted by the pair of tags involved, solid
+//! contacts are resolved, and the remaining contacts are handed to each
+//! object's components together, as one GenericComponent::collisions call
+//! per object. The pairs touching are kept across ticks in a ContactCache,
+//! which adds begin and persist events after each object's collisions and
+//! end events once a pair parts.
+//!
+//! Contacts are found along the whole motion of the tick, not only at the
+//! end: two boxes that touch at some moment between where they started and
+//! where they ended collide, and a non-solid object that would pass through
+//! a solid one is stopped at the face it reached first. Fast objects do not
+//! tunnel, so the level can be stepped at a coarser tick with the same
+//! results.
+//!
+//! Only objects with physics components take part. A non-solid object is
+//! pushed out of the solid objects it overlaps and collides with the
+//! non-solid objects it overlaps; solid objects do not collide with each
+//! other. Pairs whose collision layers do not interact (see
+//! CollisionLayers) are dropped as the sweep meets them, before any
+//! overlap test.
+//!
+//! Only the level's awake objects move and are swept against each other.
+//! Objects at rest are kept sorted along x between ticks: those that come
+//! to rest or take another index are inserted, those that wake or leave
+//! are skipped until the list is rebuilt, which happens only when the level
+//! numbers all its objects again or skipped entries pile up. Each awake object is checked against the ones
+//! its extent reaches, and objects at rest never collide with each other,
+//! so a tick costs in proportion to the awake objects.
+class CollisionStage {
+public:
+    //! \brief Two overlapping objects, by their index in the level.
+    struct Contact {
+        std::uint64_t tags; //!< the smaller tag in the high half, the larger in the low half
+        std::uint32_t a, b; //!< a < b, unless b is solid
+        bool solid; //!< if b is solid and a is pushed out of it
+        std::uint32_t cached; //!< the pair's entry in the contact cache if it was there unchanged when gathered, or ContactCache::NONE
+    };
+
+    //! \brief An axis-aligned box.
+    struct Box {
+        float x, y, w, h;
+    };
+
+    CollisionStage();
+
+    //! \brief Find when a box moving by (dx, dy) over a tick first touches a
+    //! still box it did not start out touching. On a hit, time is the
+    //! fraction of the move made before touching and xAxis says whether the
+    //! faces that met are vertical.
+    static bool sweep(const Box& moving, float dx, float dy, const Box& still, float& time, bool& xAxis);
+
+    //! \brief Move, collide and dispatch the given objects of the level,
+    //! which must not change until this returns; additions and removals
+    //! made by collision handlers are deferred by the level as usual.
+    void step(Level& level, const std::vector<std::shared_ptr<GameObject>>& objects);
+    void prepare(const Level& level, const std::vector<std::shared_ptr<GameObject>>& objects); //!< Sort the objects at rest for the next step now, as after a load.
+
+    inline CollisionLayers& layers() { return mLayers; } //!< Get which collision layers interact.
+    inline const CollisionLayers& layers() const { return mLayers; }
+
+    inline const ContactCache& contactCache() const { return mContactCache; } //!< Get the pairs touching, kept across ticks.
+    inline void loadContacts(SnapshotReader& reader) { mContactCache.load(reader); } //!< Restore the pairs touching, for Level::restore.
+    inline void renumber(const Level& level) { mContactCache.renumber(level); } //!< Catch up with objects removed from the level and the objects moved into their places.
+    inline const std::vector<Contact>& contacts() const { return mContacts; } //!< Get the contacts of the last step, sorted by tag pair.
+
+private:
+    CollisionStage(const CollisionStage&) = delete;
+    void operator=(CollisionStage const&) = delete;
+
+    //! \brief An object taking part, with where it was before moving.
+    struct Body {
+        GameObject* object;
+        std::uint32_t index; //!< index in the level
+        int x0, x1; //!< horizontal extent swept while moving, as collision tests round it
+        float oldX, oldY;
+        std::uint32_t layer; //!< the bit of its collision layer
+        std::uint32_t mask; //!< the layers it may touch
+        bool solid;
+    };
+
+    //! \brief A collision to hand to an object's components.
+    struct Event {
+        std::uint32_t receiver, other; //!< indices in the level
+        std::uint32_t order; //!< position of the contact, so each receiver sees its contacts by tag pair
+        bool began; //!< if the contact is new this tick
+    };
+
+    //! \brief An object at rest, by its extent along x.
+    struct Resting {
+        const GameObject* object; //!< to tell if another object took the index since
+        std::uint32_t index; //!< index in the level
+        int x0, x1;
+    };
+    static bool restingOrder(const Resting& a, const Resting& b); //!< Order resting entries by x0, then index.
+
+    Body makeBody(GameObject& obj, std::uint32_t index, const PhysicsComponent& physics) const;
+    static bool interacts(const Body& a, const Body& b); //!< Get if two bodies may touch: not both solid, on layers that interact.
+    bool touched(const Body& a, const Body& b) const; //!< Get if two bodies touched at the end of or during the tick.
+    //! \brief Get the contact cache's entry for two non-solid bodies whose
+    //! boxes overlap, if they overlapped when it was made and neither has
+    //! moved since, so they touch without a test; ContactCache::NONE otherwise.
+    std::uint32_t cachedEntry(const Body& a, const Body& b) const;
+    void addContact(const Body& a, const Body& b, std::uint32_t cached);
+    void keepResting(const Body& body); //!< Add an object at rest to mRestingBodies, unless it is there already.
+
+    void sortResting(const Level& level, const std::vector<std::shared_ptr<GameObject>>& objects);
+    void addResting(const std::vector<std::uint32_t>& indices, const std::vector<std::shared_ptr<GameObject>>& objects);
+    bool isResting(const Resting& resting, const std::vector<std::shared_ptr<GameObject>>& objects) const; //!< Get if an entry of mResting is current: its object is still at rest there, at that index.
+    void gather(const std::vector<std::shared_ptr<GameObject>>& objects);
+    void resolve();
+    void dispatch(Level& level, const std::vector<std::shared_ptr<GameObject>>& objects);
+    void dispatchEnded(Level& level); //!< Hand the pairs that parted to those of their objects still in the level.
+
+    CollisionLayers mLayers;
+
+    std::vector<Body> mBodies; //!< the awake objects taking part, then the objects at rest they touched
+    std::vector<std::uint32_t> mBodyOf; //!< index in mBodies of each object of the level taking part
+    std::vector<Body> mRestingBodies; //!< objects at rest touched, while gathering
+
+    std::vector<Resting> mResting; //!< objects at rest taking part, by x0 then index, and entries gone stale since
+    int mRestingWidth; //!< widest extent in mResting
+    std::uint64_t mRestingVersion; //!< the numbering of the level's objects mResting uses
+
+    ContactCache mContactCache;
+    std::vector<Contact> mContacts;
+    std::vector<Event> mEvents;
+    std::vector<std::shared_ptr<GameObject>> mGroup; //!< the objects one receiver collided with
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "base/ContactCache.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include "base/Snapshot.hpp"
+#include <algorithm>
+#include <utility>
+
+ContactCache::ContactCache()
+    : mStep(0)
+    , mVersion(~std::uint64_t(0))
+{
+}
+
+std::size_t ContactCache::home(std::uint64_t key) const
+{
+    // indices are small and dense, so mix both halves into the low bits
+    std::uint64_t hash = key * 0x9e3779b97f4a7c15ull;
+    hash ^= hash >> 32;
+    return std::size_t(hash) & (mSlots.size() - 1);
+}
+
+std::size_t ContactCache::slotOf(std::uint64_t key) const
+{
+    if (mSlots.empty()) {
+        return 0;
+    }
+    const std::size_t mask = mSlots.size() - 1;
+    for (std::size_t slot = home(key);; slot = (slot + 1) & mask) {
+        if (mSlots[slot].key == key) {
+            return slot;
+        }
+        if (mSlots[slot].key == EMPTY) {
+            return mSlots.size();
+        }
+    }
+}
+
+void ContactCache::place(std::uint64_t key, std::uint32_t entry)
+{
+    const std::size_t mask = mSlots.size() - 1;
+    std::size_t slot = home(key);
+    while (mSlots[slot].key != EMPTY) {
+        slot = (slot + 1) & mask;
+    }
+    mSlots[slot] = { key, entry };
+}
+
+void ContactCache::rehash(std::size_t size)
+{
+    mSlots.assign(size, Slot());
+    for (std::uint32_t ii = 0; ii < mEntries.size(); ++ii) {
+        place(mEntries[ii].key, ii);
+    }
+}
+
+ContactCache::Entry& ContactCache::insert(std::uint64_t key)
+{
+    if ((mEntries.size() + 1) * 2 > mSlots.size()) {
+        rehash(std::max<std::size_t>(16, mSlots.size() * 2));
+    }
+    place(key, std::uint32_t(mEntries.size()));
+    mEntries.emplace_back();
+    mEntries.back().key = key;
+    return mEntries.back();
+}
+
+void ContactCache::erase(std::size_t slot)
+{
+    const std::uint32_t entry = mSlots[slot].entry;
+    const std::size_t mask = mSlots.size() - 1;
+    for (std::size_t next = (slot + 1) & mask; mSlots[next].key != EMPTY; next = (next + 1) & mask) {
+        // a later key moves into the hole unless its home lies after the hole, up to it
+        const std::size_t from = home(mSlots[next].key);
+        const bool stays = slot <= next ? (slot < from && from <= next) : (slot < from || from <= next);
+        if (!stays) {
+            mSlots[slot] = mSlots[next];
+            slot = next;
+        }
+    }
+    mSlots[slot].key = EMPTY;
+
+    // the last pair fills the gap
+    if (entry + 1 != mEntries.size()) {
+        mEntries[entry] = std::move(mEntries.back());
+        mSlots[slotOf(mEntries[entry].key)].entry = entry;
+    }
+    mEntries.pop_back();
+}
+
+void ContactCache::clear()
+{
+    for (Slot& slot : mSlots) {
+        slot.key = EMPTY;
+    }
+    mEntries.clear();
+}
+
+bool ContactCache::touching(const Level& level, const GameObject& a, const GameObject& b) const
+{
+    if (mVersion != level.partitionVersion()) {
+        // numbered again since the last step; the keys are stale
+        for (const Entry& entry : mEntries) {
+            if ((entry.a.get() == &a && entry.b.get() == &b) || (entry.a.get() == &b && entry.b.get() == &a)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    const std::uint32_t first = std::min(a.levelIndex(), b.levelIndex());
+    const std::uint32_t second = std::max(a.levelIndex(), b.levelIndex());
+    const std::size_t slot = slotOf(key(first, second));
+    return slot < mSlots.size() && (mEntries[mSlots[slot].entry].a.get() == &a || mEntries[mSlots[slot].entry].a.get() == &b);
+}
+
+void ContactCache::begin(const Level& level)
+{
+    ++mStep;
+    if (mVersion == level.partitionVersion()) {
+        return;
+    }
+    mVersion = level.partitionVersion();
+    renumber(level);
+}
+
+void ContactCache::renumber(const Level& level)
+{
+    std::size_t kept = 0;
+    for (Entry& entry : mEntries) {
+        if (!level.hasObject(entry.a) || !level.hasObject(entry.b)) {
+            mEnded.push_back({ entry.key, std::move(entry.a), std::move(entry.b) });
+            continue;
+        }
+        if (entry.a->levelIndex() > entry.b->levelIndex()) {
+            std::swap(entry.a, entry.b);
+            std::swap(entry.versionA, entry.versionB);
+        }
+        entry.key = key(entry.a->levelIndex(), entry.b->levelIndex());
+        if (&entry != &mEntries[kept]) {
+            mEntries[kept] = std::move(entry);
+        }
+        ++kept;
+    }
+    mEntries.resize(kept);
+    rehash(mSlots.size());
+    std::sort(mEnded.begin(), mEnded.end(), [](const Ended& a, const Ended& b) { return a.key < b.key; });
+}
+
+ContactCache::Entry* ContactCache::find(std::uint32_t a, std::uint32_t b)
+{
+    const std::size_t slot = slotOf(key(a, b));
+    return slot < mSlots.size() ? &mEntries[mSlots[slot].entry] : nullptr;
+}
+
+bool ContactCache::unchanged(const Entry& entry) const
+{
+    return entry.overlapping && entry.a->boundsVersion() == entry.versionA && entry.b->boundsVersion() == entry.versionB;
+}
+
+std::uint32_t ContactCache::findUnchanged(std::uint32_t a, std::uint32_t b) const
+{
+    const std::size_t slot = slotOf(key(a, b));
+    if (slot == mSlots.size() || !unchanged(mEntries[mSlots[slot].entry])) {
+        return NONE;
+    }
+    return mSlots[slot].entry;
+}
+
+bool ContactCache::touch(Entry* entry, std::uint32_t a, std::uint32_t b, const std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    const bool began = !entry;
+    if (began) {
+        entry = &insert(key(a, b));
+        entry->a = objects[a];
+        entry->b = objects[b];
+    } else if (unchanged(*entry)) {
+        entry->seen = mStep;
+        return false;
+    }
+    entry->versionA = entry->a->boundsVersion();
+    entry->versionB = entry->b->boundsVersion();
+    entry->seen = mStep;
+    entry->overlapping = entry->a->isColliding(*entry->b);
+    return began;
+}
+
+void ContactCache::end()
+{
+    // find the pairs that ended first, as erasing moves other pairs
+    const std::size_t earlier = mEnded.size();
+    for (const Entry& entry : mEntries) {
+        const bool resting = entry.a->activity() != GameObject::AWAKE && entry.b->activity() != GameObject::AWAKE;
+        if (entry.seen == mStep || (resting && unchanged(entry))) {
+            continue;
+        }
+        mEnded.push_back({ entry.key, entry.a, entry.b });
+    }
+    for (std::size_t ii = earlier; ii < mEnded.size(); ++ii) {
+        erase(slotOf(mEnded[ii].key));
+    }
+    std::sort(mEnded.begin() + earlier, mEnded.end(), [](const Ended& a, const Ended& b) { return a.key < b.key; });
+}
+
+void ContactCache::save(Snapshot& snapshot) const
+{
+    // by key, so equal states make equal snapshots
+    mKeys.clear();
+    for (const Entry& entry : mEntries) {
+        mKeys.push_back(entry.key);
+    }
+    std::sort(mKeys.begin(), mKeys.end());
+
+    snapshot.write(std::uint32_t(mKeys.size()));
+    for (std::uint64_t k : mKeys) {
+        const Entry& entry = mEntries[mSlots[slotOf(k)].entry];
+        snapshot.write(k);
+        snapshot.writeShared(entry.a);
+        snapshot.writeShared(entry.b);
+    }
+}
+
+void ContactCache::load(SnapshotReader& reader)
+{
+    clear();
+    mEnded.clear();
+    std::uint32_t count;
+    reader.read(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint64_t k;
+        reader.read(k);
+        Entry& entry = insert(k);
+        entry.a = reader.readShared<GameObject>();
+        entry.b = reader.readShared<GameObject>();
+        entry.versionA = entry.a->boundsVersion();
+        entry.versionB = entry.b->boundsVersion();
+        entry.seen = mStep;
+        entry.overlapping = false;
+    }
+    // the level numbers its objects again after a restore, so re-key then
+    mVersion = ~std::uint64_t(0);
+}
@@ -0,0 +1,108 @@
+#ifndef BASE_CONTACT_CACHE
+#define BASE_CONTACT_CACHE
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GameObject;
+class Level;
+class Snapshot;
+class SnapshotReader;
+
+//! \brief The pairs of objects touching, kept across ticks by the level's
+//! CollisionStage, so a contact has a beginning and an end.
+//!
+//! Pairs are kept densely, and found by the objects' indices in the level
+//! through a flat hash table with open addressing. Both keep their memory
+//! across ticks, so new contacts do not allocate once they have grown to
+//! the level's usual number of them, and the end of a step and a save visit
+//! only the pairs, however large the table once grew. Pairs are re-keyed
+//! when the level removes objects, moving others into their places, or
+//! numbers its objects again. A pair found by the physics step begins if
+//! it was not cached and persists if it was; a cached pair the step did not
+//! find ends, and so, at the next step, does a pair one of whose objects
+//! left the level, which only the object still in it is told of. A pair
+//! neither of whose boxes has changed since it last overlapped still
+//! overlaps, by the objects' bounds versions, so the step takes it as
+//! touching without testing it again. Two objects both at rest are not
+//! checked against each other, so a pair of them stays touching, without
+//! persist events, until one moves.
+//!
+//! Only contacts handed to components count; solid contacts, which are
+//! resolved instead, are not cached.
+class ContactCache {
+public:
+    ContactCache();
+
+    inline std::size_t size() const { return mEntries.size(); } //!< Get how many pairs are touching.
+    bool touching(const Level& level, const GameObject& a, const GameObject& b) const; //!< Get if two objects of a level are touching.
+
+    void save(Snapshot& snapshot) const; //!< Write the pairs to a snapshot.
+    void load(SnapshotReader& reader); //!< Read back what save wrote.
+
+private:
+    ContactCache(const ContactCache&) = delete;
+    void operator=(ContactCache const&) = delete;
+
+    friend class CollisionStage;
+
+    //! \brief A touching pair.
+    struct Entry {
+        std::uint64_t key;
+        std::shared_ptr<GameObject> a, b; //!< a is first in the level, as of the key
+        std::uint32_t versionA, versionB; //!< the objects' bounds versions as of the last step that found the pair
+        std::uint64_t seen; //!< the last step that found the pair
+        bool overlapping; //!< if the boxes overlapped at the end of that step, rather than only touching on the way
+    };
+
+    //! \brief A pair that stopped touching, to hand to its objects.
+    struct Ended {
+        std::uint64_t key; //!< the pair's key when it ended, to order the events
+        std::shared_ptr<GameObject> a, b;
+    };
+
+    static constexpr std::uint64_t EMPTY = ~std::uint64_t(0); //!< not a key, as an object is never paired with itself
+    static constexpr std::uint32_t NONE = ~std::uint32_t(0); //!< not the index of a pair
+
+    //! \brief A slot of the table: a key and the index of its pair, or EMPTY.
+    struct Slot {
+        std::uint64_t key = EMPTY;
+        std::uint32_t entry = 0;
+    };
+
+    static inline std::uint64_t key(std::uint32_t a, std::uint32_t b) { return std::uint64_t(a) << 32 | b; }
+
+    std::size_t home(std::uint64_t key) const; //!< Get the slot a key is probed from.
+    std::size_t slotOf(std::uint64_t key) const; //!< Get the slot holding a key, or the table's size if none does.
+    void place(std::uint64_t key, std::uint32_t entry); //!< Put a key that is not in the table into its first free slot.
+    void rehash(std::size_t size); //!< Index every pair again in an empty table of the given size.
+    Entry& insert(std::uint64_t key); //!< Add a key that is not in the table, growing it if need be.
+    void erase(std::size_t slot); //!< Drop the pair in a slot, moving later keys of the same run back to keep probes unbroken.
+    void clear(); //!< Drop every pair, keeping the table's size.
+
+    //! \brief Start a physics step: re-key the pairs if the level numbered
+    //! its objects again, ending the pairs of objects that left it.
+    void begin(const Level& level);
+    //! \brief Re-key the pairs by their objects' current indices, ending
+    //! the pairs of objects that left the level.
+    void renumber(const Level& level);
+    Entry* find(std::uint32_t a, std::uint32_t b); //!< Get the cached pair of two objects by index, a before b, if any.
+    bool unchanged(const Entry& entry) const; //!< Get if a pair overlapped and neither object's box has changed since.
+    std::uint32_t findUnchanged(std::uint32_t a, std::uint32_t b) const; //!< Get the index in mEntries of the cached pair of two objects by index, a before b, if it overlapped and has not moved since, or NONE.
+    //! \brief Record that the step found two objects touching, given their
+    //! entry from find; returns if the contact begins. Entries keep their
+    //! indices until the step ends.
+    bool touch(Entry* entry, std::uint32_t a, std::uint32_t b, const std::vector<std::shared_ptr<GameObject>>& objects);
+    void end(); //!< Finish a step, moving the pairs it did not find to mEnded.
+
+    std::vector<Entry> mEntries; //!< the pairs, in no particular order
+    std::vector<Slot> mSlots; //!< a power of two of them, or none; at most half full
+    mutable std::vector<std::uint64_t> mKeys; //!< scratch for save, kept to reuse
+    std::vector<Ended> mEnded; //!< by key, handed out and cleared by the stage
+    std::uint64_t mStep;
+    std::uint64_t mVersion; //!< the numbering of the level's objects the keys use
+};
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef BASE_COROUTINE_ACTION
+#define BASE_COROUTINE_ACTION
+
+#include "base/BehaviorTree.hpp"
+#include "base/CoroutineScheduler.hpp"
+#include "base/Pool.hpp"
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+class GameObject;
+
+//! \brief The coroutine type of a CoroutineAction's body, which ends with
+//! co_return of the action's status. Frames are drawn from the Pool.
+class CoTask {
+public:
+    struct promise_type {
+        Status mResult = Status::FAILURE;
+
+        CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(Status status) { mResult = status; }
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(std::size_t size) { return Pool::allocate(size); }
+        static void operator delete(void* frame, std::size_t size) noexcept { Pool::deallocate(frame, size); }
+    };
+
+    CoTask() { }
+    CoTask(CoTask&& other) noexcept
+        : mHandle(std::exchange(other.mHandle, nullptr))
+    {
+    }
+    CoTask& operator=(CoTask&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            mHandle = std::exchange(other.mHandle, nullptr);
+        }
+        return *this;
+    }
+    ~CoTask() { reset(); }
+
+    inline explicit operator bool() const { return bool(mHandle); } //!< Get if there is a coroutine.
+    inline bool done() const { return mHandle.done(); } //!< Get if the coroutine has returned.
+    inline void resume() { mHandle.resume(); }
+    inline Status result() const { return mHandle.promise().mResult; } //!< Get what the finished coroutine returned.
+
+    //! \brief Destroy the coroutine, wherever it is suspended.
+    void reset()
+    {
+        if (mHandle) {
+            mHandle.destroy();
+            mHandle = nullptr;
+        }
+    }
+
+private:
+    explicit CoTask(std::coroutine_handle<promise_type> handle)
+        : mHandle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+//! \brief Wait for a condition, checked once per tick, or a deadline.
+template <typename Condition>
+class CoUntil : public CoWait {
+public:
+    CoUntil(Level& level, Condition condition, Uint32 deadline, GameObject* owner = nullptr)
+        : CoWait(level, deadline, true, owner)
+        , mCondition(std::move(condition))
+    {
+    }
+
+protected:
+    virtual bool ready(Level&) override { return mCondition(); }
+
+private:
+    Condition mCondition;
+};
+
+//! \brief Wait for an object to arrive at a point, moving it toward the
+//! point with the level's steering batch each tick meanwhile.
+class CoArrive : public CoWait {
+public:
+    CoArrive(Level& level, GameObject& gameObject, float x, float y, float speed, GameObject* owner = nullptr)
+        : CoWait(level, NEVER, true, owner)
+        , mGameObject(gameObject)
+        , mX(x)
+        , mY(y)
+        , mSpeed(speed)
+        , mArrived(false)
+    {
+    }
+
+protected:
+    virtual bool ready(Level& level) override
+    {
+        if (!mArrived) {
+            level.steering().queue(mGameObject, mX, mY, mSpeed, &mArrived);
+        }
+        return mArrived;
+    }
+
+private:
+    GameObject& mGameObject;
+    const float mX, mY, mSpeed;
+    bool mArrived; //!< set by the steering batch when flushed
+};
+
+//! \brief A leaf node whose behavior is a coroutine, which can co_await a
+//! duration, a condition or an arrival instead of being polled every tick
+//! and keeping its progress by hand. While the coroutine is parked the node
+//! just reports RUNNING and counts as parked, so a tree waiting on it lets
+//! its object sleep; the level's CoroutineScheduler resumes it when its
+//! wait is over and wakes the object, and the node returns the coroutine's
+//! status on the next tick of the tree.
+//!
+//! Coroutine frames cannot be saved to snapshots. Loading one discards a
+//! running coroutine and starts the body again, so bodies should derive
+//! what they wait for from state the node saves (start times, targets)
+//! rather than from when they happened to start.
+class CoroutineAction : public BehaviorNode {
+public:
+    virtual Status update() override
+    {
+        if (!mTask) {
+            mTask = run();
+            mTask.resume();
+        }
+        if (!mTask.done()) {
+            return Status::RUNNING;
+        }
+        Status status = mTask.result();
+        mTask.reset();
+        return status;
+    }
+
+    // a node entered afresh starts its body again; actions with set up of
+    // their own to do on entering extend this
+    virtual void onEnter() override
+    {
+        mTask.reset();
+    }
+
+    virtual void onExit() override
+    {
+        mTask.reset();
+    }
+
+    // a started coroutine not yet done is suspended on a wait
+    virtual bool parked() const override { return isRunning() && mTask && !mTask.done(); }
+
+    virtual void load(SnapshotReader& reader) override
+    {
+        BehaviorNode::load(reader);
+        mTask.reset();
+    }
+
+protected:
+    virtual CoTask run() = 0; //!< The action's body, started when the node starts running.
+
+    inline CoWait sleepUntil(Uint32 time) { return CoWait(*mLevel, time, false, mOwner); } //!< Wait until the level's time reaches a point.
+    inline CoWait sleepFor(Uint32 duration) { return CoWait(*mLevel, mLevel->time() + duration, false, mOwner); } //!< Wait for a number of milliseconds.
+
+    //! \brief Wait until condition() is true, or the deadline passes.
+    template <typename Condition>
+    CoUntil<Condition> until(Condition condition, Uint32 deadline = CoWait::NEVER)
+    {
+        return CoUntil<Condition>(*mLevel, std::move(condition), deadline, mOwner);
+    }
+
+    //! \brief Move an object toward a point at speed each tick until it arrives.
+    inline CoArrive arrive(GameObject& gameObject, float x, float y, float speed) { return CoArrive(*mLevel, gameObject, x, y, speed, mOwner); }
+
+private:
+    CoTask mTask;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "base/CoroutineScheduler.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include <algorithm>
+
+CoWait::CoWait(Level& level, Uint32 deadline, bool polled, GameObject* owner)
+    : mLevel(level)
+    , mDeadline(deadline)
+    , mPolled(polled)
+    , mOwner(owner)
+    , mScheduler(nullptr)
+    , mIndex(0)
+{
+}
+
+CoWait::~CoWait()
+{
+    if (mScheduler) {
+        mScheduler->unpark(*this);
+    }
+}
+
+bool CoWait::await_ready()
+{
+    return mLevel.time() >= mDeadline || (mPolled && ready(mLevel));
+}
+
+void CoWait::await_suspend(std::coroutine_handle<> handle)
+{
+    mHandle = handle;
+    mLevel.coroutines().park(*this);
+}
+
+CoroutineScheduler::CoroutineScheduler()
+    : mOrder(0)
+{
+}
+
+CoroutineScheduler::~CoroutineScheduler()
+{
+    // frames may outlive the level; their waits must not call back
+    for (const Timer& timer : mTimers) {
+        timer.wait->mScheduler = nullptr;
+    }
+    for (CoWait* wait : mPolled) {
+        wait->mScheduler = nullptr;
+    }
+}
+
+bool CoroutineScheduler::later(const Timer& a, const Timer& b)
+{
+    return a.deadline != b.deadline ? a.deadline > b.deadline : a.order > b.order;
+}
+
+void CoroutineScheduler::park(CoWait& wait)
+{
+    wait.mScheduler = this;
+    if (wait.mPolled) {
+        wait.mIndex = mPolled.size();
+        mPolled.push_back(&wait);
+    } else {
+        mTimers.push_back({ wait.mDeadline, mOrder++, &wait });
+        std::push_heap(mTimers.begin(), mTimers.end(), later);
+    }
+}
+
+void CoroutineScheduler::unpark(CoWait& wait)
+{
+    wait.mScheduler = nullptr;
+    if (wait.mPolled) {
+        mPolled[wait.mIndex] = mPolled.back();
+        mPolled[wait.mIndex]->mIndex = wait.mIndex;
+        mPolled.pop_back();
+    } else {
+        // only when a frame is dropped while asleep, so a linear search will do
+        auto elem = std::find_if(mTimers.begin(), mTimers.end(), [&wait](const Timer& timer) { return timer.wait == &wait; });
+        *elem = mTimers.back();
+        mTimers.pop_back();
+        std::make_heap(mTimers.begin(), mTimers.end(), later);
+    }
+}
+
+void CoroutineScheduler::update(Level& level)
+{
+    const Uint32 now = level.time();
+
+    mDue.clear();
+    while (!mTimers.empty() && mTimers.front().deadline <= now) {
+        std::pop_heap(mTimers.begin(), mTimers.end(), later);
+        mTimers.back().wait->mScheduler = nullptr;
+        mDue.push_back(mTimers.back().wait);
+        mTimers.pop_back();
+    }
+    for (std::size_t ii = 0; ii < mPolled.size();) {
+        CoWait* wait = mPolled[ii];
+        if (now >= wait->mDeadline || wait->ready(level)) {
+            unpark(*wait);
+            mDue.push_back(wait);
+        } else {
+            ++ii;
+        }
+    }
+
+    // resuming can park coroutines again, so only once the lists are settled;
+    // the wait is gone once its coroutine moves on, so wake its owner first
+    for (CoWait* wait : mDue) {
+        if (wait->mOwner) {
+            wait->mOwner->wake();
+        }
+        wait->mHandle.resume();
+    }
+    mDue.clear();
+}
@@ -0,0 +1,89 @@
+#ifndef BASE_COROUTINE_SCHEDULER
+#define BASE_COROUTINE_SCHEDULER
+
+#include <SDL.h>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CoroutineScheduler;
+class GameObject;
+class Level;
+
+//! \brief Something a suspended coroutine waits for: a time, a condition
+//! checked once per tick, or both. Awaitables derive from it; co_await on
+//! one returns at once if it is already satisfied, else parks the coroutine
+//! with the level's scheduler until it is. A wait that is destroyed while
+//! parked, with the coroutine frame holding it, takes itself off the
+//! scheduler. A wait can name the object whose behavior it belongs to,
+//! which is woken when the wait is over, so the object can sleep meanwhile.
+class CoWait {
+public:
+    static const Uint32 NEVER = 0xffffffff; //!< a deadline that never passes
+
+    CoWait(Level& level, Uint32 deadline, bool polled, GameObject* owner = nullptr);
+    virtual ~CoWait();
+
+    bool await_ready();
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() { }
+
+protected:
+    //! \brief Get if the wait is over, besides its deadline passing. Called
+    //! once per tick while parked, if the wait is polled.
+    virtual bool ready(Level& level) { return false; }
+
+    Level& mLevel;
+
+private:
+    CoWait(const CoWait&) = delete;
+    void operator=(CoWait const&) = delete;
+
+    friend class CoroutineScheduler;
+
+    const Uint32 mDeadline;
+    const bool mPolled; //!< if ready must be checked each tick; if not, only the deadline can end the wait
+    GameObject* const mOwner; //!< woken when the wait is over, if any
+    CoroutineScheduler* mScheduler; //!< the scheduler the wait is parked with, if any
+    std::size_t mIndex; //!< position in the scheduler's polled list
+    std::coroutine_handle<> mHandle;
+};
+
+//! \brief Resumes a level's parked coroutines when what they wait for comes
+//! about. Waits with only a deadline sit in a heap ordered by time, so a
+//! sleeping coroutine costs nothing until it is due; waits on conditions
+//! are checked once per tick. The level updates the scheduler before its
+//! objects, so coroutines resumed in a tick act in that same tick.
+class CoroutineScheduler {
+public:
+    CoroutineScheduler();
+    ~CoroutineScheduler();
+
+    void update(Level& level); //!< Resume the coroutines whose waits are over.
+
+    inline std::size_t parked() const { return mTimers.size() + mPolled.size(); } //!< Get the number of coroutines waiting.
+
+private:
+    CoroutineScheduler(const CoroutineScheduler&) = delete;
+    void operator=(CoroutineScheduler const&) = delete;
+
+    friend class CoWait;
+
+    void park(CoWait& wait);
+    void unpark(CoWait& wait);
+
+    struct Timer {
+        Uint32 deadline;
+        std::uint64_t order; //!< when it was parked, so timers due together resume in that order
+        CoWait* wait;
+    };
+    static bool later(const Timer& a, const Timer& b); //!< min-heap order on deadline, then order
+
+    std::vector<Timer> mTimers; //!< a min-heap of the waits on a deadline alone
+    std::vector<CoWait*> mPolled; //!< the waits checked each tick
+    std::vector<CoWait*> mDue; //!< waits found over this tick, to resume
+    std::uint64_t mOrder;
+};
+
+#endif
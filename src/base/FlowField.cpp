@@ -0,0 +1,111 @@
+#include "base/FlowField.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include "base/NavGrid.hpp"
+#include "base/Steering.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+static const unsigned UNREACHABLE = std::numeric_limits<unsigned>::max();
+
+FlowField::FlowField(const NavGrid& grid)
+    : mGrid(grid)
+    , mTargetKey(nullptr)
+    , mTargetCell(-1)
+    , mGridVersion(0)
+{
+}
+
+void FlowField::setTarget(std::weak_ptr<GameObject> target)
+{
+    mTarget = target;
+    std::shared_ptr<GameObject> targetShared = target.lock();
+    mTargetKey = targetShared.get();
+    mTargetCell = -1;
+}
+
+void FlowField::update(const Level& level)
+{
+    std::shared_ptr<GameObject> target = mTarget.lock();
+    if (!target || !level.hasObject(target)) {
+        mTargetCell = -1;
+        return;
+    }
+
+    const int cx = mGrid.cellX(target->x() + target->w() * 0.5f);
+    const int cy = mGrid.cellY(target->y() + target->h() * 0.5f);
+    const int targetCell = cy * mGrid.cols() + cx;
+    if (targetCell != mTargetCell || mGrid.version() != mGridVersion) {
+        rebuild(targetCell);
+    }
+}
+
+bool FlowField::nextWaypoint(float x, float y, float& wx, float& wy) const
+{
+    if (mTargetCell < 0) {
+        return false;
+    }
+
+    const int cell = mGrid.cellY(y) * mGrid.cols() + mGrid.cellX(x);
+    const int next = mNext[cell];
+    if (cell == mTargetCell || next < 0) {
+        return false;
+    }
+
+    wx = mGrid.centerX(next % mGrid.cols());
+    wy = mGrid.centerY(next / mGrid.cols());
+    return true;
+}
+
+void FlowField::steer(GameObject& agent, const GameObject& target, float speed, SteeringBatch& steering) const
+{
+    // head for the center of the next cell, i.e. put the agent's center there
+    float wx, wy;
+    if (leadsTo(&target) && nextWaypoint(agent.x() + agent.w() * 0.5f, agent.y() + agent.h() * 0.5f, wx, wy)) {
+        steering.queue(agent, wx - agent.w() * 0.5f, wy - agent.h() * 0.5f, speed);
+    } else {
+        steering.queue(agent, target.x(), target.y(), speed);
+    }
+}
+
+void FlowField::rebuild(int targetCell)
+{
+    const int cols = mGrid.cols();
+    const size_t cells = size_t(cols) * mGrid.rows();
+    mCost.assign(cells, UNREACHABLE);
+    mNext.assign(cells, -1);
+    mTargetCell = targetCell;
+    mGridVersion = mGrid.version();
+
+    // Dijkstra outward from the target; the target's own cell is always open
+    // so a target standing against a wall still has a field
+    mOpen.clear();
+    mCost[targetCell] = 0;
+    mOpen.push_back(std::make_pair(0u, targetCell));
+    while (!mOpen.empty()) {
+        std::pop_heap(mOpen.begin(), mOpen.end(), std::greater<std::pair<unsigned, int>>());
+        const unsigned cost = mOpen.back().first;
+        const int cell = mOpen.back().second;
+        mOpen.pop_back();
+        if (cost != mCost[cell]) {
+            continue;
+        }
+
+        const int cx = cell % cols;
+        const int cy = cell / cols;
+        for (int dir = 0; dir < 8; ++dir) {
+            if (!mGrid.canStep(cx, cy, dir)) {
+                continue;
+            }
+            const int neighbor = (cy + NavGrid::STEP_DY[dir]) * cols + cx + NavGrid::STEP_DX[dir];
+            const unsigned neighborCost = cost + NavGrid::STEP_COST[dir];
+            if (neighborCost < mCost[neighbor]) {
+                mCost[neighbor] = neighborCost;
+                mNext[neighbor] = cell;
+                mOpen.push_back(std::make_pair(neighborCost, neighbor));
+                std::push_heap(mOpen.begin(), mOpen.end(), std::greater<std::pair<unsigned, int>>());
+            }
+        }
+    }
+}
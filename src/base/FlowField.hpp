@@ -0,0 +1,53 @@
+#ifndef BASE_FLOW_FIELD
+#define BASE_FLOW_FIELD
+
+#include <memory>
+#include <vector>
+
+class GameObject;
+class Level;
+class NavGrid;
+class SteeringBatch;
+
+//! \brief A shared navigation field toward one target object. It holds, for
+//! every cell of the level's NavGrid, the neighbouring cell on a shortest
+//! path to the target around blocked cells. The level rebuilds it only when
+//! the target changes cells or obstacles change, so any number of agents can
+//! chase the target for the cost of one lookup each.
+class FlowField {
+public:
+    FlowField(const NavGrid& grid);
+
+    void setTarget(std::weak_ptr<GameObject> target); //!< Set the object the field leads to.
+    inline bool leadsTo(const GameObject* target) const { return target && target == mTargetKey; } //!< Get if the field leads to the given object.
+
+    void update(const Level& level); //!< Rebuild if needed; called once per tick by the level.
+
+    //! \brief Get the point an agent at the given position should head for
+    //! next: the center of the next cell on its path. Returns false if the
+    //! agent is already in the target's cell or cannot reach it.
+    bool nextWaypoint(float x, float y, float& wx, float& wy) const;
+
+    //! \brief Queue a move of the agent toward the target at the given speed:
+    //! along the field if it leads to that target, straight at it otherwise.
+    void steer(GameObject& agent, const GameObject& target, float speed, SteeringBatch& steering) const;
+
+private:
+    FlowField(const FlowField&) = delete;
+    void operator=(FlowField const&) = delete;
+
+    void rebuild(int targetCell);
+
+    const NavGrid& mGrid;
+
+    std::weak_ptr<GameObject> mTarget;
+    const GameObject* mTargetKey;
+    int mTargetCell; //!< cell the field was built toward, or -1 if there is no field
+    unsigned mGridVersion; //!< version of the grid the field was built on
+
+    std::vector<unsigned> mCost; //!< integrated path cost from each cell to the target
+    std::vector<int> mNext; //!< next cell toward the target from each cell, or -1
+    std::vector<std::pair<unsigned, int>> mOpen; //!< heap of (cost, cell) while building
+};
+
+#endif
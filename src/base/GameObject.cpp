@@ -1,4 +1,6 @@
 #include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include "base/Snapshot.hpp"
 #include <SDL.h>
 
 GameObject::GameObject(float x, float y, float w, float h, int tag)
@@ -6,7 +8,17 @@ GameObject::GameObject(float x, float y, float w, float h, int tag)
     , mY(y)
     , mW(w)
     , mH(h)
+    , mBoundsVersion(0)
     , mTag(tag)
+    , mLastRenderRect { 0, 0, 0, 0 }
+    , mRendered(false)
+    , mRenderDirty(true)
+    , mLevel(nullptr)
+    , mLevelIndex(0)
+    , mSetSlot(0)
+    , mTagSlot(0)
+    , mActivity(AWAKE)
+    , mWoken(false)
 {
     mData = nullptr;
 }
@@ -15,6 +27,38 @@ GameObject::~GameObject()
 {
 }
 
+void GameObject::addGenericCompenent(std::shared_ptr<GenericComponent> comp)
+{
+    mGenericComponents.push_back(comp);
+    wake();
+}
+
+void GameObject::setPhysicsCompenent(std::shared_ptr<PhysicsComponent> comp)
+{
+    mPhysicsComponent = comp;
+    wake();
+}
+
+void GameObject::wake()
+{
+    if (mActivity != AWAKE && mLevel) {
+        mLevel->wake(*this);
+    }
+}
+
+bool GameObject::canRest() const
+{
+    if (mPhysicsComponent && (mPhysicsComponent->vx() != 0.0f || mPhysicsComponent->vy() != 0.0f)) {
+        return false;
+    }
+    for (auto& comp : mGenericComponents) {
+        if (!comp->canSleep()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void GameObject::update(Level& level)
 {
     for (auto genericComponent : mGenericComponents) {
@@ -29,6 +73,34 @@ void GameObject::collision(Level& level, std::shared_ptr<GameObject> obj)
     }
 }
 
+void GameObject::collisions(Level& level, const std::vector<std::shared_ptr<GameObject>>& objs)
+{
+    for (auto genericComponent : mGenericComponents) {
+        genericComponent->collisions(level, objs);
+    }
+}
+
+void GameObject::collisionBegin(Level& level, std::shared_ptr<GameObject> obj)
+{
+    for (auto genericComponent : mGenericComponents) {
+        genericComponent->collisionBegin(level, obj);
+    }
+}
+
+void GameObject::collisionPersist(Level& level, std::shared_ptr<GameObject> obj)
+{
+    for (auto genericComponent : mGenericComponents) {
+        genericComponent->collisionPersist(level, obj);
+    }
+}
+
+void GameObject::collisionEnd(Level& level, std::shared_ptr<GameObject> obj)
+{
+    for (auto genericComponent : mGenericComponents) {
+        genericComponent->collisionEnd(level, obj);
+    }
+}
+
 void GameObject::step(Level& level)
 {
     if (mPhysicsComponent) {
@@ -43,6 +115,46 @@ void GameObject::render(SDL_Renderer* renderer)
     }
 }
 
+void GameObject::save(Snapshot& snapshot) const
+{
+    snapshot.write(mX);
+    snapshot.write(mY);
+    snapshot.write(mW);
+    snapshot.write(mH);
+    snapshot.writeShared(mRenderComponent);
+    if (mRenderComponent) {
+        mRenderComponent->save(snapshot);
+    }
+    if (mPhysicsComponent) {
+        mPhysicsComponent->save(snapshot);
+    }
+    for (auto& comp : mGenericComponents) {
+        comp->save(snapshot);
+    }
+}
+
+void GameObject::load(SnapshotReader& reader)
+{
+    reader.read(mX);
+    reader.read(mY);
+    reader.read(mW);
+    reader.read(mH);
+    ++mBoundsVersion;
+    std::shared_ptr<RenderComponent> renderComponent = reader.readShared<RenderComponent>();
+    if (renderComponent != mRenderComponent) {
+        setRenderCompenent(renderComponent);
+    }
+    if (mRenderComponent && mRenderComponent->load(reader)) {
+        mRenderDirty = true;
+    }
+    if (mPhysicsComponent) {
+        mPhysicsComponent->load(reader);
+    }
+    for (auto& comp : mGenericComponents) {
+        comp->load(reader);
+    }
+}
+
 bool GameObject::isColliding(const GameObject& obj) const
 {
     SDL_Rect thisRect = { int(x()), int(y()), int(w()), int(h()) };
@@ -57,3 +169,19 @@ bool GameObject::isColliding(float px, float py) const
     SDL_Point point = { int(px), int(py) };
     return SDL_PointInRect(&point, &thisRect);
 }
+
+bool GameObject::needsRedraw() const
+{
+    if (mRenderDirty || !mRendered) {
+        return true;
+    }
+    SDL_Rect rect = renderRect();
+    return rect.x != mLastRenderRect.x || rect.y != mLastRenderRect.y || rect.w != mLastRenderRect.w || rect.h != mLastRenderRect.h;
+}
+
+void GameObject::markRendered()
+{
+    mLastRenderRect = renderRect();
+    mRendered = true;
+    mRenderDirty = false;
+}
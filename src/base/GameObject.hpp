@@ -2,64 +2,151 @@
 #define BASE_GAME_OBJECT
 
 #include "base/GenericComponent.hpp"
+#include "base/Memory.hpp"
 #include "base/PhysicsComponent.hpp"
 #include "base/RenderComponent.hpp"
 #include <SDL.h>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 const float SIZE = 30.0f;
 
 class Level;
+class Snapshot;
+class SnapshotReader;
 
 //! \brief Represents an object in the game.  Has some essential
 //! properties (position and size), a tag (identifying the general
 //! category of object), and a collection of components, including any
 //! number of generic components and optionally a physics component
 //! and a render component.
+//!
+//! In a level, an object is awake, sleeping or static. Only awake objects
+//! are updated and stepped; the level puts an object to rest when updating
+//! it would do nothing (see canRest). Moving it, setting a velocity or
+//! adding components wakes it again, and so does a contact if it is
+//! sleeping rather than static.
 class GameObject {
 public:
+    //! \brief How much work the level does for an object.
+    enum Activity {
+        AWAKE, //!< updated and stepped every tick
+        SLEEPING, //!< at rest, with components that only react to contacts; woken by them
+        STATIC, //!< at rest, without generic components
+    };
+
+    static constexpr Memory::Category MEMORY_CATEGORY = Memory::LEVEL; //!< what makePooled charges objects, and the components they make, to
+
     GameObject(float x, float y, float w, float h, int tag);
     virtual ~GameObject();
 
     inline int tag() const { return mTag; }
 
-    inline void setX(float x) { mX = x; }
-    inline void setY(float y) { mY = y; }
+    inline void setX(float x)
+    {
+        if (x != mX) {
+            mX = x;
+            ++mBoundsVersion;
+        }
+        if (mActivity != AWAKE) {
+            wake();
+        }
+    }
+    inline void setY(float y)
+    {
+        if (y != mY) {
+            mY = y;
+            ++mBoundsVersion;
+        }
+        if (mActivity != AWAKE) {
+            wake();
+        }
+    }
 
     inline float x() const { return mX; }
     inline float y() const { return mY; }
     inline float w() const { return mW; }
     inline float h() const { return mH; }
-
-    inline void addGenericCompenent(std::shared_ptr<GenericComponent> comp) { mGenericComponents.push_back(comp); }
-    inline void setPhysicsCompenent(std::shared_ptr<PhysicsComponent> comp) { mPhysicsComponent = comp; }
-    inline void setRenderCompenent(std::shared_ptr<RenderComponent> comp) { mRenderComponent = comp; }
+    inline std::uint32_t boundsVersion() const { return mBoundsVersion; } //!< Get a number that changes whenever the object's box does.
+
+    void addGenericCompenent(std::shared_ptr<GenericComponent> comp);
+    void setPhysicsCompenent(std::shared_ptr<PhysicsComponent> comp);
+    inline void setRenderCompenent(std::shared_ptr<RenderComponent> comp)
+    {
+        mRenderComponent = comp;
+        mRenderDirty = true;
+    }
+    //! \brief Change the color the object is drawn in. The object is only
+    //! marked for redraw if the color is different.
+    inline void setColor(Uint8 r, Uint8 g, Uint8 b)
+    {
+        if (mRenderComponent && mRenderComponent->setColor(r, g, b)) {
+            mRenderDirty = true;
+        }
+    }
 
     inline std::vector<std::shared_ptr<GenericComponent>> genericComponents() { return mGenericComponents; }
     inline std::shared_ptr<PhysicsComponent> physicsComponent() { return mPhysicsComponent; }
+    inline const PhysicsComponent* physicsComponent() const { return mPhysicsComponent.get(); }
+    inline bool hasGenericComponents() const { return !mGenericComponents.empty(); }
     inline std::shared_ptr<RenderComponent> renderComponent() { return mRenderComponent; }
 
     void update(Level& level); //!< Update the object.
     void collision(Level& level, std::shared_ptr<GameObject> obj); //!< Handle collisions with another object.
+    void collisions(Level& level, const std::vector<std::shared_ptr<GameObject>>& objs); //!< Handle all of this tick's collisions at once.
+    void collisionBegin(Level& level, std::shared_ptr<GameObject> obj); //!< Handle starting to touch another object.
+    void collisionPersist(Level& level, std::shared_ptr<GameObject> obj); //!< Handle still touching another object.
+    void collisionEnd(Level& level, std::shared_ptr<GameObject> obj); //!< Handle no longer touching another object.
     void step(Level& level); //!< Do the physics step for the object.
     void render(SDL_Renderer* renderer); //!< Render the object.
 
+    inline Activity activity() const { return mActivity; }
+    inline std::uint32_t levelIndex() const { return mLevelIndex; } //!< Get the object's index in its level, while it is in one.
+    void wake(); //!< Have the level update and step the object again, from the next chance it gets.
+    bool canRest() const; //!< Get if updating and stepping would do nothing: it is still, and its components can all sleep.
+
+    //! \brief Write the object's state to a snapshot: its rectangle, render
+    //! component and components. Objects with state of their own extend this.
+    virtual void save(Snapshot& snapshot) const;
+    virtual void load(SnapshotReader& reader); //!< Read back what save wrote.
+
     bool isColliding(const GameObject& obj) const; //!< Determine if this object is colliding with another.
     bool isColliding(float px, float py) const; //!< Determine if this object is colliding with a point.
 
+    inline SDL_Rect renderRect() const { return { int(mX), int(mY), int(mW), int(mH) }; } //!< Get the screen region the object covers now.
+    inline const SDL_Rect& lastRenderRect() const { return mLastRenderRect; } //!< Get the screen region the object covered when last drawn.
+    inline bool wasRendered() const { return mRendered; } //!< Get if the object has been drawn since it was created.
+    bool needsRedraw() const; //!< Determine if the object moved or was recolored since it was last drawn.
+    void markRendered(); //!< Remember the current region as the one last drawn.
+
     void* mData;
 
 private:
     GameObject(const GameObject&) = delete;
     void operator=(GameObject const&) = delete;
 
+    friend class Level;
+
     float mX, mY, mW, mH;
+    std::uint32_t mBoundsVersion; //!< bumped when the box changes
     int mTag;
 
     std::vector<std::shared_ptr<GenericComponent>> mGenericComponents;
     std::shared_ptr<PhysicsComponent> mPhysicsComponent;
     std::shared_ptr<RenderComponent> mRenderComponent;
+
+    SDL_Rect mLastRenderRect;
+    bool mRendered;
+    bool mRenderDirty;
+
+    // kept by the level the object is in
+    Level* mLevel;
+    std::uint32_t mLevelIndex; //!< position in the level's objects
+    std::uint32_t mSetSlot; //!< position in the level's set for its activity
+    std::uint32_t mTagSlot; //!< position in the level's list of objects with its tag
+    Activity mActivity;
+    bool mWoken; //!< woken and not updated since, so not ready to rest
 };
 
 #endif
@@ -12,3 +12,35 @@ void GenericComponent::update(Level& level)
 void GenericComponent::collision(Level& level, std::shared_ptr<GameObject> obj)
 {
 }
+
+void GenericComponent::collisions(Level& level, const std::vector<std::shared_ptr<GameObject>>& objs)
+{
+    for (auto& obj : objs) {
+        collision(level, obj);
+    }
+}
+
+void GenericComponent::collisionBegin(Level& level, std::shared_ptr<GameObject> obj)
+{
+}
+
+void GenericComponent::collisionPersist(Level& level, std::shared_ptr<GameObject> obj)
+{
+}
+
+void GenericComponent::collisionEnd(Level& level, std::shared_ptr<GameObject> obj)
+{
+}
+
+bool GenericComponent::canSleep() const
+{
+    return false;
+}
+
+void GenericComponent::save(Snapshot& snapshot) const
+{
+}
+
+void GenericComponent::load(SnapshotReader& reader)
+{
+}
@@ -2,17 +2,41 @@
 #define BASE_GENERIC_COMPONENT
 
 #include "base/Component.hpp"
+#include "base/Memory.hpp"
 #include <memory>
+#include <vector>
 
 class Level;
+class Snapshot;
+class SnapshotReader;
 
 //! \brief A generic component that can handle updating and collisions.
 class GenericComponent : public Component {
 public:
+    static constexpr Memory::Category MEMORY_CATEGORY = Memory::AI; //!< what makePooled charges generic components to
+
     GenericComponent(GameObject& gameObject);
 
     virtual void update(Level& level); //!< Update the object.
     virtual void collision(Level& level, std::shared_ptr<GameObject> obj); //!< Handle a collision with the given object.
+
+    //! \brief Handle all of this tick's collisions at once, grouped by the
+    //! tags of the objects involved. By default calls collision for each.
+    virtual void collisions(Level& level, const std::vector<std::shared_ptr<GameObject>>& objs);
+
+    //! \brief Handle starting to touch an object, once per contact, after
+    //! this tick's collisions. See ContactCache.
+    virtual void collisionBegin(Level& level, std::shared_ptr<GameObject> obj);
+    virtual void collisionPersist(Level& level, std::shared_ptr<GameObject> obj); //!< Handle still touching an object, on each tick after the first that it is touched.
+    virtual void collisionEnd(Level& level, std::shared_ptr<GameObject> obj); //!< Handle no longer touching an object, or it having left the level.
+
+    //! \brief Get if the component has nothing to do in update until its
+    //! object is woken, so a still object with only such components can be
+    //! put to sleep. By default, no.
+    virtual bool canSleep() const;
+
+    virtual void save(Snapshot& snapshot) const; //!< Write the component's state to a snapshot.
+    virtual void load(SnapshotReader& reader); //!< Read back what save wrote.
 };
 
 #endif
@@ -0,0 +1,160 @@
+#include "base/InfluenceMap.hpp"
+#include "base/GameObject.hpp"
+#include "base/NavGrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+InfluenceMap::InfluenceMap(int w, int h, float cellSize)
+    : mCols(std::max(1, int(std::ceil(w / cellSize))))
+    , mRows(std::max(1, int(std::ceil(h / cellSize))))
+    , mCellSize(cellSize)
+{
+}
+
+void InfluenceMap::addLayer(int tag, float strength, float radius)
+{
+    if (layerOf(tag) >= 0) {
+        return;
+    }
+
+    Layer layer;
+    layer.tag = tag;
+    layer.reach = std::max(0, int(std::ceil(radius / mCellSize)));
+    int side = 2 * layer.reach + 1;
+    layer.kernel.resize(size_t(side) * side);
+    for (int dy = -layer.reach; dy <= layer.reach; ++dy) {
+        for (int dx = -layer.reach; dx <= layer.reach; ++dx) {
+            float d = std::sqrt(float(dx * dx + dy * dy)) * mCellSize;
+            float weight = radius > 0.0f ? std::max(0.0f, 1.0f - d / radius) : (d == 0.0f ? 1.0f : 0.0f);
+            layer.kernel[(dy + layer.reach) * side + dx + layer.reach] = int(std::lround(strength * weight * SCALE));
+        }
+    }
+    layer.values.assign(size_t(mCols) * mRows, 0);
+    mLayers.push_back(std::move(layer));
+}
+
+void InfluenceMap::update(const std::vector<std::shared_ptr<GameObject>>& objects, const std::vector<std::uint32_t>& indices)
+{
+    if (mLayers.empty()) {
+        return;
+    }
+
+    for (std::uint32_t i : indices) {
+        const std::shared_ptr<GameObject>& obj = objects[i];
+        int layer = layerOf(obj->tag());
+        if (layer < 0) {
+            continue;
+        }
+
+        int cx = cellX(obj->x() + obj->w() * 0.5f);
+        int cy = cellY(obj->y() + obj->h() * 0.5f);
+
+        auto elem = mStamps.find(obj.get());
+        if (elem == mStamps.end()) {
+            mStamps[obj.get()] = { layer, cx, cy };
+        } else if (elem->second.cx != cx || elem->second.cy != cy) {
+            stamp(mLayers[layer], elem->second.cx, elem->second.cy, -1);
+            elem->second.cx = cx;
+            elem->second.cy = cy;
+        } else {
+            continue;
+        }
+        stamp(mLayers[layer], cx, cy, 1);
+    }
+}
+
+void InfluenceMap::remove(const GameObject& obj)
+{
+    auto elem = mStamps.find(&obj);
+    if (elem == mStamps.end()) {
+        return;
+    }
+
+    stamp(mLayers[elem->second.layer], elem->second.cx, elem->second.cy, -1);
+    mStamps.erase(elem);
+}
+
+float InfluenceMap::influence(int tag, float x, float y) const
+{
+    int layer = layerOf(tag);
+    if (layer < 0) {
+        return 0.0f;
+    }
+    return float(mLayers[layer].values[cellY(y) * mCols + cellX(x)]) / SCALE;
+}
+
+bool InfluenceMap::safestPoint(int tag, float x, float y, float radius, const NavGrid* grid, float& sx, float& sy) const
+{
+    int layerId = layerOf(tag);
+    if (layerId < 0) {
+        return false;
+    }
+    const Layer& layer = mLayers[layerId];
+
+    int cx = cellX(x);
+    int cy = cellY(y);
+    int reach = std::max(0, int(std::ceil(radius / mCellSize)));
+
+    bool found = false;
+    int bestValue = 0;
+    int bestDistance = 0;
+    for (int y1 = std::max(cy - reach, 0); y1 <= std::min(cy + reach, mRows - 1); ++y1) {
+        for (int x1 = std::max(cx - reach, 0); x1 <= std::min(cx + reach, mCols - 1); ++x1) {
+            int value = layer.values[y1 * mCols + x1];
+            int distance = (x1 - cx) * (x1 - cx) + (y1 - cy) * (y1 - cy);
+            if (found && (value > bestValue || (value == bestValue && distance >= bestDistance))) {
+                continue;
+            }
+
+            float px = (x1 + 0.5f) * mCellSize;
+            float py = (y1 + 0.5f) * mCellSize;
+            if (grid && grid->isBlocked(grid->cellX(px), grid->cellY(py))) {
+                continue;
+            }
+
+            found = true;
+            bestValue = value;
+            bestDistance = distance;
+            sx = px;
+            sy = py;
+        }
+    }
+    return found;
+}
+
+int InfluenceMap::layerOf(int tag) const
+{
+    for (size_t i = 0; i < mLayers.size(); ++i) {
+        if (mLayers[i].tag == tag) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+int InfluenceMap::cellX(float x) const
+{
+    return std::min(std::max(int(std::floor(x / mCellSize)), 0), mCols - 1);
+}
+
+int InfluenceMap::cellY(float y) const
+{
+    return std::min(std::max(int(std::floor(y / mCellSize)), 0), mRows - 1);
+}
+
+void InfluenceMap::stamp(Layer& layer, int cx, int cy, int sign)
+{
+    int side = 2 * layer.reach + 1;
+    int x0 = std::max(cx - layer.reach, 0);
+    int x1 = std::min(cx + layer.reach, mCols - 1);
+    int y0 = std::max(cy - layer.reach, 0);
+    int y1 = std::min(cy + layer.reach, mRows - 1);
+
+    for (int y = y0; y <= y1; ++y) {
+        int* values = &layer.values[y * mCols + x0];
+        const int* weights = &layer.kernel[(y - cy + layer.reach) * side + x0 - cx + layer.reach];
+        for (int i = 0; i <= x1 - x0; ++i) {
+            values[i] += sign * weights[i];
+        }
+    }
+}
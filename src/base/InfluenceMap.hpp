@@ -0,0 +1,73 @@
+#ifndef BASE_INFLUENCE_MAP
+#define BASE_INFLUENCE_MAP
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+class NavGrid;
+
+//! \brief Coarse grids of how strongly objects of a tag influence each part
+//! of the level, e.g. how dangerous it is near enemies. Each object of a
+//! tag with a layer stamps a falloff kernel around its cell into that
+//! layer. The level updates the map once per tick after physics with the
+//! objects that may have moved, and only those that reached another cell
+//! are restamped, so reading the influence at a point is a single lookup.
+class InfluenceMap {
+public:
+    InfluenceMap(int w, int h, float cellSize);
+
+    //! \brief Make objects with the given tag contribute strength at their
+    //! own cell, falling off linearly to nothing at radius.
+    void addLayer(int tag, float strength, float radius);
+
+    //! \brief Restamp the objects at the given indices that changed cells;
+    //! called once per tick by the level with its awake objects.
+    void update(const std::vector<std::shared_ptr<GameObject>>& objects, const std::vector<std::uint32_t>& indices);
+    void remove(const GameObject& obj); //!< Take an object's stamp out of its layer.
+
+    float influence(int tag, float x, float y) const; //!< Get the influence of a tag at a point, 0 if it has no layer.
+
+    //! \brief Find the center of the cell with the least influence of a tag
+    //! within radius of (x, y), skipping cells whose center is blocked in
+    //! grid if one is given; ties go to the nearest cell. Returns false if
+    //! the tag has no layer or no cell is open.
+    bool safestPoint(int tag, float x, float y, float radius, const NavGrid* grid, float& sx, float& sy) const;
+
+    inline float cellSize() const { return mCellSize; }
+
+private:
+    InfluenceMap(const InfluenceMap&) = delete;
+    void operator=(InfluenceMap const&) = delete;
+
+    // influence is kept in fixed point so removing a stamp exactly undoes adding it
+    static const int SCALE = 1024;
+
+    struct Layer {
+        int tag;
+        int reach; //!< kernel radius in cells
+        std::vector<int> kernel; //!< (2 * reach + 1)^2 weights centered on the object's cell
+        std::vector<int> values;
+    };
+
+    //! \brief Where an object is stamped.
+    struct Stamp {
+        int layer;
+        int cx, cy;
+    };
+
+    int layerOf(int tag) const;
+    int cellX(float x) const;
+    int cellY(float y) const;
+    void stamp(Layer& layer, int cx, int cy, int sign);
+
+    int mCols, mRows;
+    float mCellSize;
+
+    std::vector<Layer> mLayers;
+    std::unordered_map<const GameObject*, Stamp> mStamps;
+};
+
+#endif
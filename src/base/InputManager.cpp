@@ -1,44 +1,94 @@
 #include "InputManager.hpp"
 #include <algorithm>
 
-InputManager& InputManager::getInstance()
-{
-    static InputManager* instance = new InputManager();
-    return *instance;
-}
-
 void InputManager::startUp()
 {
+    if (!mWatching) {
+        SDL_AddEventWatch(&InputManager::watchEvent, this);
+        mWatching = true;
+    }
 }
 
 void InputManager::shutDown()
 {
+    if (mWatching) {
+        SDL_DelEventWatch(&InputManager::watchEvent, this);
+        mWatching = false;
+    }
 }
 
 void InputManager::resetForFrame()
 {
-    mKeysPressed.clear();
+    mKeysPressed.reset();
 }
 
 void InputManager::handleEvent(const SDL_Event& e)
 {
-    if (e.type == SDL_KEYDOWN) {
-        auto elem = mKeysDown.find(e.key.keysym.sym);
-        if (elem == mKeysDown.end()) {
-            mKeysPressed.insert(e.key.keysym.sym);
-        }
-        mKeysDown.insert(e.key.keysym.sym);
-    } else if (e.type == SDL_KEYUP) {
-        mKeysDown.erase(e.key.keysym.sym);
+    if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) {
+        applyKey(e.key.keysym.scancode, e.type == SDL_KEYDOWN, SDL_GetPerformanceCounter());
+    }
+}
+
+void InputManager::consumeEvents(Uint64 until)
+{
+    const KeyEvent* next;
+    while ((next = mEvents.peek()) && next->time <= until) {
+        applyKey(next->scancode, next->down, next->time);
+        KeyEvent done;
+        mEvents.pop(done);
     }
 }
 
 bool InputManager::isKeyDown(SDL_Keycode k) const
 {
-    return mKeysDown.find(k) != mKeysDown.end();
+    SDL_Scancode s = toScancode(k);
+    return s != SDL_SCANCODE_UNKNOWN && mKeysDown[s];
 }
 
 bool InputManager::isKeyPressed(SDL_Keycode k) const
 {
-    return mKeysPressed.find(k) != mKeysPressed.end();
+    SDL_Scancode s = toScancode(k);
+    return s != SDL_SCANCODE_UNKNOWN && mKeysPressed[s];
+}
+
+void InputManager::setKeys(const KeySet& down, const KeySet& pressed)
+{
+    mKeysDown = down;
+    mKeysPressed = pressed;
+}
+
+int InputManager::watchEvent(void* userdata, SDL_Event* e)
+{
+    if (e->type == SDL_KEYDOWN || e->type == SDL_KEYUP) {
+        InputManager* self = static_cast<InputManager*>(userdata);
+        KeyEvent event = { SDL_GetPerformanceCounter(), e->key.keysym.scancode, e->type == SDL_KEYDOWN };
+        if (!self->mEvents.push(event)) {
+            self->mDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return 1;
+}
+
+SDL_Scancode InputManager::toScancode(SDL_Keycode k)
+{
+    // keys without a character (arrows, function keys...) carry their scancode
+    if (k & SDLK_SCANCODE_MASK) {
+        SDL_Scancode s = SDL_Scancode(k & ~SDLK_SCANCODE_MASK);
+        return s < SDL_NUM_SCANCODES ? s : SDL_SCANCODE_UNKNOWN;
+    }
+    return SDL_GetScancodeFromKey(k);
+}
+
+void InputManager::applyKey(SDL_Scancode scancode, bool down, Uint64 time)
+{
+    if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES) {
+        return;
+    }
+    if (down && !mKeysDown[scancode]) {
+        mKeysPressed[scancode] = true;
+    }
+    if (down != mKeysDown[scancode]) {
+        mKeyTime[scancode] = time;
+    }
+    mKeysDown[scancode] = down;
 }
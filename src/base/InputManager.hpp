@@ -1,25 +1,69 @@
+#ifndef BASE_INPUT_MANAGER
+#define BASE_INPUT_MANAGER
+
+#include "base/SpscRing.hpp"
 #include <SDL.h>
-#include <set>
+#include <atomic>
+#include <bitset>
 
 //! \brief Class for managing (keyboard) input.
+//!
+//! Once started up, key events are stamped with the performance counter as
+//! SDL receives them and queued in a lock-free ring, instead of waiting for
+//! the game loop to poll. The loop applies them at tick boundaries with
+//! consumeEvents. Key state is a bitset indexed by scancode.
+//!
+//! Each level has its own input manager; only the one the program loop
+//! starts up is fed by SDL, and others are set directly (replays, batch
+//! runs).
 class InputManager {
 private:
-    InputManager() = default; // Private Singleton
     InputManager(InputManager const&) = delete; // Avoid copy constructor.
     void operator=(InputManager const&) = delete; // Don't allow copy assignment.
 
 public:
-    static InputManager& getInstance(); //!< Get the instance.
+    InputManager() = default;
+
+    typedef std::bitset<SDL_NUM_SCANCODES> KeySet;
+
+    //! \brief A key going down or up, and when SDL received it.
+    struct KeyEvent {
+        Uint64 time; //!< performance counter value on arrival
+        SDL_Scancode scancode;
+        bool down;
+    };
 
-    void startUp();
+    void startUp(); //!< Start queueing key events as they arrive.
     void shutDown();
 
     void resetForFrame(); //!< Reset key state for a new frame.
-    void handleEvent(const SDL_Event& e); //!< Update key state based on an event.
+    void handleEvent(const SDL_Event& e); //!< Update key state based on an event, right away.
+    void consumeEvents(Uint64 until); //!< Apply the queued events that arrived up to a performance counter value, oldest first.
+
     bool isKeyDown(SDL_Keycode k) const; //!< Get if a key is currently down.
     bool isKeyPressed(SDL_Keycode k) const; //!< Get if a key was pressed this frame.
+    inline bool isScancodeDown(SDL_Scancode s) const { return mKeysDown[s]; } //!< Get if a physical key is currently down.
+    inline bool isScancodePressed(SDL_Scancode s) const { return mKeysPressed[s]; } //!< Get if a physical key was pressed this frame.
+    inline Uint64 keyTime(SDL_Scancode s) const { return mKeyTime[s]; } //!< Get when a key last went down or up, as a performance counter value.
+
+    inline const KeySet& keysDown() const { return mKeysDown; } //!< Get the keys currently down.
+    inline const KeySet& keysPressed() const { return mKeysPressed; } //!< Get the keys pressed this frame.
+    void setKeys(const KeySet& down, const KeySet& pressed); //!< Replace the key state, e.g. with a recorded frame.
+
+    inline unsigned droppedEvents() const { return mDropped.load(std::memory_order_relaxed); } //!< Get how many events were lost to a full queue.
 
 private:
-    std::set<SDL_Keycode> mKeysDown;
-    std::set<SDL_Keycode> mKeysPressed;
+    static int watchEvent(void* userdata, SDL_Event* e); //!< SDL event watch; the queue's producer
+    static SDL_Scancode toScancode(SDL_Keycode k);
+    void applyKey(SDL_Scancode scancode, bool down, Uint64 time);
+
+    KeySet mKeysDown;
+    KeySet mKeysPressed;
+    Uint64 mKeyTime[SDL_NUM_SCANCODES] = {};
+
+    SpscRing<KeyEvent, 256> mEvents;
+    std::atomic<unsigned> mDropped { 0 };
+    bool mWatching = false;
 };
+
+#endif
@@ -0,0 +1,98 @@
+#include "base/InputRecording.hpp"
+#include "base/Memory.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+static const char MAGIC[4] = { 'P', 'G', 'I', 'R' };
+static const std::uint32_t VERSION = 2;
+
+InputRecording::InputRecording()
+    : mSeed(0)
+{
+}
+
+void InputRecording::capture(Uint32 time, const InputManager& input)
+{
+    MemoryScope scope(Memory::INPUT);
+    mFrames.push_back({ time, input.keysDown(), input.keysPressed() });
+}
+
+void InputRecording::apply(size_t ii, InputManager& input) const
+{
+    input.setKeys(mFrames[ii].keysDown, mFrames[ii].keysPressed);
+}
+
+template <typename T>
+static void put(std::ostream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool get(std::istream& in, T& value)
+{
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool InputRecording::save(const char* path, std::string& error) const
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write(MAGIC, sizeof(MAGIC));
+    put(out, VERSION);
+    put(out, std::uint32_t(mSeed));
+    put(out, std::uint32_t(mFrames.size()));
+    for (const Frame& frame : mFrames) {
+        put(out, std::uint32_t(frame.time));
+        put(out, std::uint16_t(frame.keysDown.count()));
+        put(out, std::uint16_t(frame.keysPressed.count()));
+        for (const InputManager::KeySet* keys : { &frame.keysDown, &frame.keysPressed }) {
+            for (std::size_t key = 0; key < keys->size(); ++key) {
+                if (keys->test(key)) {
+                    put(out, std::uint16_t(key));
+                }
+            }
+        }
+    }
+    if (!out) {
+        error = std::string("cannot write ") + path;
+        return false;
+    }
+    return true;
+}
+
+bool InputRecording::load(const char* path, std::string& error)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    std::uint32_t version, seed, count;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0
+        || !get(in, version) || version != VERSION || !get(in, seed) || !get(in, count)) {
+        error = std::string(path) + ": not an input recording";
+        return false;
+    }
+
+    mSeed = seed;
+    mFrames.clear();
+    mFrames.reserve(count);
+    for (std::uint32_t ii = 0; ii < count; ++ii) {
+        std::uint32_t time;
+        std::uint16_t down, pressed;
+        if (!get(in, time) || !get(in, down) || !get(in, pressed)) {
+            error = std::string(path) + ": truncated";
+            return false;
+        }
+        Frame frame;
+        frame.time = time;
+        for (int jj = 0; jj < down + pressed; ++jj) {
+            std::uint16_t key;
+            if (!get(in, key) || key >= SDL_NUM_SCANCODES) {
+                error = std::string(path) + ": truncated or corrupt";
+                return false;
+            }
+            (jj < down ? frame.keysDown : frame.keysPressed).set(key);
+        }
+        mFrames.push_back(std::move(frame));
+    }
+    return true;
+}
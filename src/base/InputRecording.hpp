@@ -0,0 +1,41 @@
+#ifndef BASE_INPUT_RECORDING
+#define BASE_INPUT_RECORDING
+
+#include "base/InputManager.hpp"
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+//! \brief The input of a play session, tick by tick, with the random seed
+//! and tick times it ran with. Played back through the InputManager by
+//! SDLGraphicsProgram::replay, it reproduces the session exactly, which
+//! also makes it a repeatable performance workload.
+class InputRecording {
+public:
+    //! \brief The input state and time of one tick.
+    struct Frame {
+        Uint32 time;
+        InputManager::KeySet keysDown;
+        InputManager::KeySet keysPressed;
+    };
+
+    InputRecording();
+
+    inline unsigned seed() const { return mSeed; }
+    inline void setSeed(unsigned seed) { mSeed = seed; }
+
+    inline size_t frameCount() const { return mFrames.size(); }
+    inline const Frame& frame(size_t ii) const { return mFrames[ii]; }
+
+    void capture(Uint32 time, const InputManager& input); //!< Append the input state of a tick.
+    void apply(size_t ii, InputManager& input) const; //!< Put a recorded tick's input state back.
+
+    bool save(const char* path, std::string& error) const;
+    bool load(const char* path, std::string& error);
+
+private:
+    unsigned mSeed;
+    std::vector<Frame> mFrames;
+};
+
+#endif
@@ -1,17 +1,64 @@
 #include "base/Level.hpp"
+#include "base/Memory.hpp"
+#include "base/Pool.hpp"
 #include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <string>
+#include <unordered_set>
 
 Level::Level(int w, int h)
     : mW(w)
     , mH(h)
+    , mPartitionVersion(0)
+    , mSensors(*this)
+    , mNavGrid(w, h, SIZE)
+    , mFlowField(mNavGrid)
+    , mPathfinder(mNavGrid)
+    , mInfluence(w, h, SIZE * 2.0f)
+    , mMetrics {
+        Stats::global().counter("level.ticks"),
+        Stats::global().histogram("level.tick_us"),
+        Stats::global().gauge("level.objects"),
+        Stats::global().histogram("physics.contacts"),
+        Stats::global().counter("ai.behavior_ticks"),
+        Stats::global().histogram("memory.pool_allocations"),
+        Stats::global().histogram("memory.scratch_bytes"),
+        Stats::global().histogram("level.awake_objects"),
+    }
+    , mBehaviorTicks(0)
+    , mFullRedraw(true)
 {
 }
 
+Level::~Level()
+{
+    // the statistics outlive the level, so take its objects out of them
+    for (auto& obj : mObjects) {
+        mMetrics.objects.add(-1);
+        tagIndex(obj->tag()).count->add(-1);
+        obj->mLevel = nullptr;
+        obj->mActivity = GameObject::AWAKE;
+    }
+}
+
 void Level::addObject(std::shared_ptr<GameObject> object)
 {
     mObjectsToAdd.push_back(object);
 }
 
+void Level::addObjects(std::vector<std::shared_ptr<GameObject>>& objects)
+{
+    if (mObjectsToAdd.empty()) {
+        mObjectsToAdd.swap(objects);
+    } else {
+        mObjectsToAdd.insert(mObjectsToAdd.end(), std::make_move_iterator(objects.begin()), std::make_move_iterator(objects.end()));
+    }
+    objects.clear();
+    // a bulk load grows the objects once, not by doubling
+    mObjects.reserve(mObjects.size() + mObjectsToAdd.size());
+}
+
 void Level::removeObject(std::shared_ptr<GameObject> object)
 {
     mObjectsToRemove.push_back(object);
@@ -19,13 +66,59 @@ void Level::removeObject(std::shared_ptr<GameObject> object)
 
 bool Level::hasObject(std::shared_ptr<GameObject> object) const
 {
-    return std::find(mObjects.begin(), mObjects.end(), object) != mObjects.end();
+    return object && object->mLevel == this;
 }
 
-bool Level::getCollisions(const GameObject& obj, std::vector<std::shared_ptr<GameObject>>& objects) const
+std::size_t Level::countObjectsWithTag(int tag) const
+{
+    const TagIndex* index = findTag(tag);
+    return index ? index->objects.size() : 0;
+}
+
+const std::vector<std::uint32_t>& Level::objectsWithTag(int tag) const
+{
+    static const std::vector<std::uint32_t> none;
+    const TagIndex* index = findTag(tag);
+    if (!index) {
+        return none;
+    }
+    if (!index->sorted) {
+        // removals leave the list out of order
+        std::sort(index->objects.begin(), index->objects.end());
+        for (std::uint32_t slot = 0; slot < index->objects.size(); ++slot) {
+            mObjects[index->objects[slot]]->mTagSlot = slot;
+        }
+        index->sorted = true;
+    }
+    return index->objects;
+}
+
+bool Level::getObjectsWithTag(int tag, std::vector<std::shared_ptr<GameObject>>& objects) const
 {
     objects.clear();
-    for (auto gameObject : mObjects) {
+    for (std::uint32_t i : objectsWithTag(tag)) {
+        objects.push_back(mObjects[i]);
+    }
+    return !objects.empty();
+}
+
+bool Level::getObjectsWithTag(int tag, float x, float y, float w, float h, std::vector<std::shared_ptr<GameObject>>& objects) const
+{
+    objects.clear();
+    for (std::uint32_t i : objectsWithTag(tag)) {
+        const GameObject& obj = *mObjects[i];
+        if (obj.x() < x + w && x < obj.x() + obj.w() && obj.y() < y + h && y < obj.y() + obj.h()) {
+            objects.push_back(mObjects[i]);
+        }
+    }
+    return !objects.empty();
+}
+
+template <typename Vector>
+static bool collectCollisions(const std::vector<std::shared_ptr<GameObject>>& candidates, const GameObject& obj, Vector& objects)
+{
+    objects.clear();
+    for (auto& gameObject : candidates) {
         if (gameObject.get() != &obj && gameObject->isColliding(obj)) {
             objects.push_back(gameObject);
         }
@@ -33,6 +126,16 @@ bool Level::getCollisions(const GameObject& obj, std::vector<std::shared_ptr<Gam
     return !objects.empty();
 }
 
+bool Level::getCollisions(const GameObject& obj, std::vector<std::shared_ptr<GameObject>>& objects) const
+{
+    return collectCollisions(mObjects, obj, objects);
+}
+
+bool Level::getCollisions(const GameObject& obj, ScratchVector<std::shared_ptr<GameObject>>& objects) const
+{
+    return collectCollisions(mObjects, obj, objects);
+}
+
 bool Level::getCollisions(float px, float py, std::vector<std::shared_ptr<GameObject>>& objects) const
 {
     objects.clear();
@@ -46,30 +149,449 @@ bool Level::getCollisions(float px, float py, std::vector<std::shared_ptr<GameOb
 
 void Level::update()
 {
-    for (auto obj : mObjectsToAdd) {
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const std::uint64_t allocations = Pool::allocations();
+    MemoryScope scope(Memory::LEVEL);
+
+    addPending();
+    applyWakes();
+    mSpatial.invalidate();
+
+    {
+        MemoryScope ai(Memory::AI);
+        mSensors.update();
+        mPathfinder.update();
+        mFlowField.update(*this);
+        mCoroutines.update(*this);
+
+        // coroutines resumed wake their objects in time to update this tick,
+        // in level order, so objects update in the same order however they woke
+        applyWakes();
+        std::sort(mAwake.begin(), mAwake.end());
+        for (std::uint32_t slot = 0; slot < mAwake.size(); ++slot) {
+            mObjects[mAwake[slot]]->mSetSlot = slot;
+        }
+        mAI.plan(*this);
+
+        // objects woken meanwhile join the set after this loop
+        for (std::uint32_t index : mAwake) {
+            std::shared_ptr<GameObject> gameObject = mObjects[index];
+            gameObject->update(*this);
+            gameObject->mWoken = false;
+        }
+        mSteering.flush();
+    }
+    applyWakes();
+    {
+        MemoryScope physics(Memory::PHYSICS);
+        mCollisions.step(*this, mObjects);
+        mRested.clear();
+    }
+    mSpatial.invalidate();
+    for (const CollisionStage::Contact& contact : mCollisions.contacts()) {
+        for (std::uint32_t index : { contact.a, contact.b }) {
+            if (mObjects[index]->activity() == GameObject::SLEEPING) {
+                wake(*mObjects[index]);
+            }
+        }
+    }
+    applyWakes();
+    {
+        MemoryScope ai(Memory::AI);
+        // objects at rest have not changed cells, and those that joined at
+        // rest are stamped once, after any layers set up since were added
+        mInfluence.update(mObjects, mAwake);
+        mInfluence.update(mObjects, mJoinedAtRest);
+        mJoinedAtRest.clear();
+    }
+
+    bool removed = false;
+    for (auto& obj : mObjectsToRemove) {
+        if (obj->mLevel == this) {
+            takeOut(*obj);
+            removed = true;
+        }
+    }
+    mObjectsToRemove.clear();
+    if (removed) {
+        mCollisions.renumber(*this);
+        mSpatial.invalidate();
+    }
+    rest();
+
+    mMetrics.contacts.record(mCollisions.contacts().size());
+    mMetrics.awake.record(mAwake.size());
+    mMetrics.behaviorTicks.add(mBehaviorTicks);
+    mBehaviorTicks = 0;
+    mMetrics.allocations.record(Pool::allocations() - allocations);
+    mMetrics.scratch.record(mScratch.used());
+    Memory::publish();
+
+    mScratch.reset();
+    mClock.advance();
+
+    mMetrics.ticks.add();
+    mMetrics.tickTime.record((SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency());
+}
+
+void Level::settle()
+{
+    MemoryScope scope(Memory::LEVEL);
+    addPending();
+    applyWakes();
+    mSpatial.invalidate();
+    // the sort takes in every object at rest, so none is added again at the next step
+    mCollisions.prepare(*this, mObjects);
+    mRested.clear();
+    {
+        MemoryScope ai(Memory::AI);
+        mPathfinder.update();
+    }
+}
+
+void Level::addPending()
+{
+    for (auto& obj : mObjectsToAdd) {
+        obj->mLevelIndex = std::uint32_t(mObjects.size());
         mObjects.push_back(obj);
+        attachObject(*obj);
+        // with nothing to update and no velocity it would only be put to
+        // rest after its first update, so it joins at rest
+        if (!obj->hasGenericComponents() && obj->canRest()) {
+            obj->mActivity = GameObject::STATIC;
+            mRested.push_back(obj->mLevelIndex);
+            mJoinedAtRest.push_back(obj->mLevelIndex);
+        }
+        join(*obj);
     }
     mObjectsToAdd.clear();
+}
 
-    for (auto gameObject : mObjects) {
-        gameObject->update(*this);
+void Level::attachObject(GameObject& obj)
+{
+    obj.mLevel = this;
+    obj.mActivity = GameObject::AWAKE;
+    mMetrics.objects.add(1);
+    TagIndex& index = tagIndex(obj.tag());
+    index.count->add(1);
+    obj.mTagSlot = std::uint32_t(index.objects.size());
+    index.objects.push_back(obj.mLevelIndex);
+    if (NavGrid::isObstacle(obj)) {
+        mNavGrid.addObstacle(obj);
     }
-    for (auto gameObject : mObjects) {
-        gameObject->step(*this);
+}
+
+void Level::detachObject(GameObject& obj)
+{
+    obj.mLevel = nullptr;
+    obj.mActivity = GameObject::AWAKE;
+    mMetrics.objects.add(-1);
+    tagIndex(obj.tag()).count->add(-1);
+    if (obj.wasRendered()) {
+        mDirtyRects.push_back(obj.lastRenderRect());
     }
+    mSensors.removeOwner(obj);
+    mAI.remove(obj);
+    mNavGrid.removeObstacle(obj);
+    mInfluence.remove(obj);
+}
+
+void Level::takeOut(GameObject& obj)
+{
+    const std::uint32_t index = obj.mLevelIndex;
+    leave(obj, obj.mActivity);
+    TagIndex& tagged = tagIndex(obj.tag());
+    GameObject& lastTagged = *mObjects[tagged.objects.back()];
+    tagged.objects[obj.mTagSlot] = lastTagged.mLevelIndex;
+    lastTagged.mTagSlot = obj.mTagSlot;
+    tagged.objects.pop_back();
+    tagged.sorted = false;
 
-    for (auto obj : mObjectsToRemove) {
-        auto elem = std::find(mObjects.begin(), mObjects.end(), obj);
-        if (elem != mObjects.end()) {
-            mObjects.erase(elem);
+    const std::uint32_t last = std::uint32_t(mObjects.size() - 1);
+    if (index != last) {
+        GameObject& moved = *mObjects[last];
+        moved.mLevelIndex = index;
+        setOf(moved.mActivity)[moved.mSetSlot] = index;
+        TagIndex& movedTagged = tagIndex(moved.tag());
+        movedTagged.objects[moved.mTagSlot] = index;
+        movedTagged.sorted = false;
+        if (moved.mActivity != GameObject::AWAKE) {
+            // the physics step knows objects at rest by index
+            mRested.push_back(index);
         }
+        mObjects[index] = std::move(mObjects[last]);
     }
-    mObjectsToRemove.clear();
+    mObjects.pop_back();
+    detachObject(obj);
+}
+
+void Level::wake(GameObject& obj)
+{
+    if (obj.mLevel != this || obj.mActivity == GameObject::AWAKE) {
+        return;
+    }
+    mWaking.push_back({ obj.mLevelIndex, obj.mActivity });
+    obj.mActivity = GameObject::AWAKE;
+    obj.mWoken = true;
+}
+
+std::vector<std::uint32_t>& Level::setOf(GameObject::Activity activity)
+{
+    switch (activity) {
+    case GameObject::SLEEPING:
+        return mSleeping;
+    case GameObject::STATIC:
+        return mStatic;
+    default:
+        return mAwake;
+    }
+}
+
+void Level::join(GameObject& obj)
+{
+    std::vector<std::uint32_t>& set = setOf(obj.mActivity);
+    obj.mSetSlot = std::uint32_t(set.size());
+    set.push_back(obj.mLevelIndex);
+}
+
+void Level::leave(GameObject& obj, GameObject::Activity activity)
+{
+    std::vector<std::uint32_t>& set = setOf(activity);
+    GameObject& last = *mObjects[set.back()];
+    set[obj.mSetSlot] = last.mLevelIndex;
+    last.mSetSlot = obj.mSetSlot;
+    set.pop_back();
+}
+
+void Level::applyWakes()
+{
+    for (const Waking& waking : mWaking) {
+        GameObject& obj = *mObjects[waking.index];
+        leave(obj, waking.from);
+        join(obj);
+        if (waking.from == GameObject::SLEEPING) {
+            mAI.wake(obj);
+        }
+    }
+    mWaking.clear();
+}
+
+void Level::rest()
+{
+    std::uint32_t kept = 0;
+    for (std::uint32_t index : mAwake) {
+        GameObject& obj = *mObjects[index];
+        if (obj.mWoken || !obj.canRest()) {
+            obj.mSetSlot = kept;
+            mAwake[kept++] = index;
+            continue;
+        }
+        obj.mActivity = obj.hasGenericComponents() ? GameObject::SLEEPING : GameObject::STATIC;
+        join(obj);
+        if (obj.mActivity == GameObject::SLEEPING) {
+            mAI.sleep(obj);
+        }
+        mRested.push_back(index);
+    }
+    mAwake.resize(kept);
+}
+
+void Level::partition()
+{
+    mAwake.clear();
+    mSleeping.clear();
+    mStatic.clear();
+    mWaking.clear();
+    mRested.clear();
+    mJoinedAtRest.clear();
+    for (TagIndex& index : mTags) {
+        index.objects.clear();
+        index.sorted = true;
+    }
+    for (std::uint32_t i = 0; i < mObjects.size(); ++i) {
+        GameObject& obj = *mObjects[i];
+        obj.mLevelIndex = i;
+        std::vector<std::uint32_t>& tagged = tagIndex(obj.tag()).objects;
+        obj.mTagSlot = std::uint32_t(tagged.size());
+        tagged.push_back(i);
+        join(obj);
+    }
+    ++mPartitionVersion;
+}
+
+Level::TagIndex& Level::tagIndex(int tag)
+{
+    for (TagIndex& index : mTags) {
+        if (index.tag == tag) {
+            return index;
+        }
+    }
+    mTags.push_back({ tag, &Stats::global().gauge("level.objects.tag." + std::to_string(tag)), {}, true });
+    return mTags.back();
+}
+
+const Level::TagIndex* Level::findTag(int tag) const
+{
+    for (const TagIndex& index : mTags) {
+        if (index.tag == tag) {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+void Level::save(Snapshot& snapshot) const
+{
+    snapshot.clear();
+    snapshot.mObjects = mObjects;
+    snapshot.mObjectsToAdd = mObjectsToAdd;
+    snapshot.mObjectsToRemove = mObjectsToRemove;
+
+    snapshot.write(mClock.now());
+    snapshot.write(mClock.ticks());
+    snapshot.write(mRandom);
+    mBlackboard.save(snapshot);
+    for (auto& obj : mObjects) {
+        obj->save(snapshot);
+    }
+    mCollisions.contactCache().save(snapshot);
+}
+
+void Level::restore(const Snapshot& snapshot)
+{
+    // objects that came or went since the snapshot leave or rejoin the
+    // level's services, as they would on removal or addition
+    std::unordered_set<const GameObject*> kept;
+    kept.reserve(snapshot.mObjects.size());
+    for (auto& obj : snapshot.mObjects) {
+        kept.insert(obj.get());
+    }
+    std::unordered_set<const GameObject*> present;
+    present.reserve(mObjects.size());
+    for (auto& obj : mObjects) {
+        present.insert(obj.get());
+        if (!kept.count(obj.get())) {
+            detachObject(*obj);
+        }
+    }
+
+    mObjects = snapshot.mObjects;
+    mObjectsToAdd = snapshot.mObjectsToAdd;
+    mObjectsToRemove = snapshot.mObjectsToRemove;
+
+    SnapshotReader reader(snapshot);
+    Uint32 now;
+    std::uint64_t ticks;
+    reader.read(now);
+    reader.read(ticks);
+    mClock.set(now, ticks);
+    reader.read(mRandom);
+    mBlackboard.load(reader);
+    for (auto& obj : mObjects) {
+        obj->load(reader);
+    }
+    mCollisions.loadContacts(reader);
+    assert(reader.atEnd() && "the level read back less than it saved");
+
+    // everything wakes; what can rest goes back to rest after the next update
+    for (auto& obj : mObjects) {
+        if (!present.count(obj.get())) {
+            attachObject(*obj);
+        }
+        obj->mActivity = GameObject::AWAKE;
+    }
+    partition();
+    mAI.wakeAll();
+    mSpatial.invalidate();
 }
 
 void Level::render(SDL_Renderer* renderer)
 {
+    MemoryScope scope(Memory::RENDER);
     for (auto gameObject : mObjects) {
         gameObject->render(renderer);
     }
 }
+
+// Grow rects that touch each other into their union until none overlap, so
+// no region is cleared and redrawn twice.
+static void mergeRects(std::vector<SDL_Rect>& rects)
+{
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            for (size_t j = i + 1; j < rects.size();) {
+                if (SDL_HasIntersection(&rects[i], &rects[j])) {
+                    SDL_UnionRect(&rects[i], &rects[j], &rects[i]);
+                    rects[j] = rects.back();
+                    rects.pop_back();
+                    merged = true;
+                } else {
+                    ++j;
+                }
+            }
+        }
+    }
+}
+
+void Level::renderDirty(SDL_Renderer* renderer, Uint8 r, Uint8 g, Uint8 b)
+{
+    MemoryScope scope(Memory::RENDER);
+    SDL_SetRenderDrawColor(renderer, r, g, b, 0xFF);
+
+    if (mFullRedraw) {
+        SDL_RenderClear(renderer);
+        for (const auto& gameObject : mObjects) {
+            gameObject->render(renderer);
+            gameObject->markRendered();
+        }
+        mDirtyRects.clear();
+        mFullRedraw = false;
+        return;
+    }
+
+    // an object that changed dirties both where it was and where it is now
+    for (const auto& gameObject : mObjects) {
+        if (gameObject->needsRedraw()) {
+            if (gameObject->wasRendered()) {
+                mDirtyRects.push_back(gameObject->lastRenderRect());
+            }
+            mDirtyRects.push_back(gameObject->renderRect());
+            gameObject->markRendered();
+        }
+    }
+    mergeRects(mDirtyRects);
+
+    // redraw each region in level order so overlapping objects stack as in a
+    // full render; nothing moves after the physics step reindexes the level,
+    // so the index finds the objects where they are drawn, give or take the
+    // pixel lost rounding to screen coordinates
+    for (const SDL_Rect& rect : mDirtyRects) {
+        SDL_RenderSetClipRect(renderer, &rect);
+        SDL_SetRenderDrawColor(renderer, r, g, b, 0xFF);
+        SDL_RenderFillRect(renderer, &rect);
+        const float x0 = float(rect.x - 1), y0 = float(rect.y - 1);
+        const float x1 = float(rect.x + rect.w + 1), y1 = float(rect.y + rect.h + 1);
+        std::size_t count = mSpatial.overlapping(*this, x0, y0, x1, y1, SpatialIndex::ANY_TAG, mRedrawn.data(), mRedrawn.size());
+        if (count > mRedrawn.size()) {
+            mRedrawn.resize(count);
+            count = mSpatial.overlapping(*this, x0, y0, x1, y1, SpatialIndex::ANY_TAG, mRedrawn.data(), mRedrawn.size());
+        }
+        std::sort(mRedrawn.begin(), mRedrawn.begin() + count);
+        for (std::size_t ii = 0; ii < count; ++ii) {
+            GameObject& gameObject = *mObjects[mRedrawn[ii]];
+            SDL_Rect objRect = gameObject.renderRect();
+            if (SDL_HasIntersection(&rect, &objRect)) {
+                gameObject.render(renderer);
+            }
+        }
+    }
+    SDL_RenderSetClipRect(renderer, nullptr);
+    mDirtyRects.clear();
+}
+
+void Level::invalidate()
+{
+    mFullRedraw = true;
+}
@@ -1,42 +1,224 @@
 #ifndef BASE_LEVEL
 #define BASE_LEVEL
 
+#include "base/AIScheduler.hpp"
+#include "base/Blackboard.hpp"
+#include "base/CollisionStage.hpp"
+#include "base/CoroutineScheduler.hpp"
+#include "base/FlowField.hpp"
 #include "base/GameObject.hpp"
+#include "base/InfluenceMap.hpp"
+#include "base/InputManager.hpp"
+#include "base/LinearArena.hpp"
+#include "base/NavGrid.hpp"
+#include "base/Pathfinder.hpp"
+#include "base/ProximitySensors.hpp"
+#include "base/Random.hpp"
+#include "base/SimClock.hpp"
+#include "base/Snapshot.hpp"
+#include "base/SpatialIndex.hpp"
+#include "base/Stats.hpp"
+#include "base/Steering.hpp"
 #include <SDL.h>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 //! \brief A level in the game.  Essentially mannages a collection of game
 //! objects, and does some collision detection.
+//!
+//! Objects are split into awake, sleeping and static sets (see
+//! GameObject::Activity). Each object knows its slot in its set, so moving
+//! it between sets costs the same however large they are. Updates and
+//! physics only go through the awake set, which is put in level order
+//! before objects update, so a large, mostly still level costs about as
+//! much as its moving parts.
+//!
+//! Objects are also indexed by tag, so finding or counting the objects with
+//! a tag costs in proportion to the matches rather than to the level. Like
+//! the sets, the index changes only where objects are added and removed, at
+//! the start and end of an update.
+//!
+//! A removed object's place in the level is taken by the last object, so a
+//! removal costs the same however many objects there are, at the price of
+//! that object's place in the render order.
+//!
+//! Radius and nearest-neighbor queries, optionally by tag, go through a
+//! SpatialIndex over the objects' centers, rebuilt lazily per tag as
+//! objects move.
+//!
+//! Each update reports to Stats::global(): the time it took, objects in
+//! play in total and by tag, contacts, behavior tree ticks and pool
+//! allocations, and memory by category when that is accounted.
 class Level {
 public:
 
   Level(int w, int h);
+  ~Level();
 
   inline int w() const { return mW; }
   inline int h() const { return mH; }
 
   void addObject(std::shared_ptr<GameObject> object); //!< Set an object to be added.
+  void addObjects(std::vector<std::shared_ptr<GameObject>> & objects); //!< Set many objects to be added, emptying the given vector.
   void removeObject(std::shared_ptr<GameObject> object); //!< Set an object to be removed.
   bool hasObject(std::shared_ptr<GameObject> object) const; //!< Get if an object is in the level.
+  inline const std::shared_ptr<GameObject> & object(std::uint32_t index) const { return mObjects[index]; } //!< Get an object by its index in the level.
+  inline std::size_t objectCount() const { return mObjects.size(); }
+
+  std::size_t countObjectsWithTag(int tag) const; //!< Get how many objects in the level have a tag.
+  const std::vector<std::uint32_t> & objectsWithTag(int tag) const; //!< Get the indices of the objects with a tag, in level order.
+  bool getObjectsWithTag(int tag, std::vector<std::shared_ptr<GameObject>> & objects) const; //!< Get the objects with a tag.
+  bool getObjectsWithTag(int tag, float x, float y, float w, float h, std::vector<std::shared_ptr<GameObject>> & objects) const; //!< Get the objects with a tag overlapping a region.
+
+  //! \brief Find the objects with a tag, or SpatialIndex::ANY_TAG, whose
+  //! centers are within a radius of a point, other than exclude. Writes at
+  //! most capacity of them to out and returns how many there are.
+  inline std::size_t objectsInRadius(float x, float y, float radius, int tag, SpatialIndex::Hit * out, std::size_t capacity, const GameObject * exclude = nullptr)
+  {
+    return mSpatial.withinRadius(*this, x, y, radius, tag, out, capacity, exclude);
+  }
+  //! \brief Find the k objects with a tag, or SpatialIndex::ANY_TAG, whose
+  //! centers are nearest a point, other than exclude. Writes them to out,
+  //! nearest first, and returns how many there are, at most k.
+  inline std::size_t nearestObjects(float x, float y, int tag, SpatialIndex::Hit * out, std::size_t k, const GameObject * exclude = nullptr)
+  {
+    return mSpatial.nearest(*this, x, y, tag, out, k, exclude);
+  }
 
   bool getCollisions(const GameObject & obj, std::vector<std::shared_ptr<GameObject>> & objects) const; //!< Get objects colliding with a given object.
   bool getCollisions(float px, float py, std::vector<std::shared_ptr<GameObject>> & objects) const; //!< Get objects colliding with a given point.
+  bool getCollisions(const GameObject & obj, ScratchVector<std::shared_ptr<GameObject>> & objects) const; //!< Get objects colliding with a given object, into scratch memory.
+
+  inline ProximitySensors & sensors() { return mSensors; } //!< Get the proximity sensors evaluated each update.
+  inline SteeringBatch & steering() { return mSteering; } //!< Get the batch of moves applied after objects update.
+  inline const NavGrid & navGrid() const { return mNavGrid; } //!< Get the grid of cells blocked by static solid objects.
+  inline FlowField & flowField() { return mFlowField; } //!< Get the shared flow field, rebuilt as its target moves.
+  inline Pathfinder & pathfinder() { return mPathfinder; } //!< Get the pathfinder over the nav grid.
+  inline InfluenceMap & influence() { return mInfluence; } //!< Get the influence map, updated after physics each tick.
+  inline CoroutineScheduler & coroutines() { return mCoroutines; } //!< Get the scheduler resuming coroutine actions, updated before objects.
+  inline AIScheduler & ai() { return mAI; } //!< Get the scheduler deciding which AI components think each tick; off by default.
+  inline const CollisionStage & collisions() const { return mCollisions; } //!< Get the physics step, and the contacts it found last tick.
+  inline const ContactCache & contactCache() const { return mCollisions.contactCache(); } //!< Get the pairs of objects touching, kept across ticks.
+  inline CollisionLayers & collisionLayers() { return mCollisions.layers(); } //!< Get which collision layers interact; all do by default.
+  inline Blackboard & blackboard() { return mBlackboard; } //!< Get the data shared by the level's AI.
+  inline const Blackboard & blackboard() const { return mBlackboard; }
+  inline InputManager & input() { return mInput; } //!< Get the input the level's objects read.
+  inline Random & random() { return mRandom; } //!< Get the level's random number generator.
+  inline LinearArena & scratch() { return mScratch; } //!< Get memory for data that only lives during the current update.
+
+  inline Uint32 time() const { return mClock.now(); } //!< Get the simulated time of the current tick, in milliseconds.
+  inline SimClock & clock() { return mClock; } //!< Get the clock, which moves on one step per update.
+  inline const SimClock & clock() const { return mClock; }
 
   void update(); //!< Update the objects in the level.
+  //! \brief Bring in the objects added since the last update now, rather
+  //! than at the start of the next one, and get the level ready to step
+  //! them: those with nothing to update go straight to rest, sorted for the
+  //! physics step, and the pathfinder is built. Loaders call this so the
+  //! first update of a large level costs no more than the ones after it.
+  void settle();
+
+  void wake(GameObject & obj); //!< Have an object at rest updated again from the next chance; see GameObject::wake.
+  inline const std::vector<std::uint32_t> & awakeObjects() const { return mAwake; } //!< Get the indices of the awake objects, in level order while objects update.
+  inline const std::vector<std::uint32_t> & sleepingObjects() const { return mSleeping; } //!< Get the indices of the sleeping objects, in no particular order.
+  inline const std::vector<std::uint32_t> & staticObjects() const { return mStatic; } //!< Get the indices of the static objects, in no particular order.
+  inline const std::vector<std::uint32_t> & restedObjects() const { return mRested; } //!< Get the indices of the objects that came to rest, or took another index at rest, since the last physics step.
+  inline std::uint64_t partitionVersion() const { return mPartitionVersion; } //!< Get a number that changes whenever all the objects are numbered again, on a restore, which makes indices kept from before stale.
+  inline void countBehaviorTick() { ++mBehaviorTicks; } //!< Count a behavior tree ticking, for the statistics.
+
+  void save(Snapshot & snapshot) const; //!< Capture the state of the level and its objects, between updates.
+  void restore(const Snapshot & snapshot); //!< Put the level back to a captured state.
   void render(SDL_Renderer * renderer); //!< Render the level.
+  void renderDirty(SDL_Renderer * renderer, Uint8 r, Uint8 g, Uint8 b); //!< Clear to the given color and redraw only the regions that changed since the last call.
+  void invalidate(); //!< Make the next renderDirty redraw the whole level.
 
 private:
   
   Level(const Level &) = delete;
   void operator=(Level const&) = delete;
 
+  void attachObject(GameObject & obj); //!< Register an object joining the level with the level's services.
+  void detachObject(GameObject & obj); //!< Unregister an object leaving the level.
+  void takeOut(GameObject & obj); //!< Remove an object, moving the last object into its place.
+
+  //! \brief The objects in the level with one tag.
+  struct TagIndex {
+    int tag;
+    StatGauge * count; //!< objects in play with the tag, across levels
+    mutable std::vector<std::uint32_t> objects; //!< indices, sorted when read
+    mutable bool sorted;
+  };
+  TagIndex & tagIndex(int tag); //!< Get the index of a tag, adding it if new.
+  const TagIndex * findTag(int tag) const;
+
+  std::vector<std::uint32_t> & setOf(GameObject::Activity activity); //!< Get the set of objects with an activity.
+  void join(GameObject & obj); //!< Add an object to the set for its activity.
+  void leave(GameObject & obj, GameObject::Activity activity); //!< Take an object out of the set for an activity.
+  void addPending(); //!< Bring in the objects set to be added, those that can rest at once at rest.
+  void applyWakes(); //!< Move the objects woken since last time to the awake set.
+  void rest(); //!< Move the awake objects that can rest to the sleeping or static set.
+  void partition(); //!< Number the objects and sort them into the sets again, after a restore.
+
+  //! \brief The statistics the level reports, looked up once.
+  struct Metrics {
+    StatCounter & ticks;
+    StatHistogram & tickTime; //!< microseconds per update
+    StatGauge & objects;
+    StatHistogram & contacts; //!< per update
+    StatCounter & behaviorTicks;
+    StatHistogram & allocations; //!< pool blocks per update
+    StatHistogram & scratch; //!< scratch bytes per update
+    StatHistogram & awake; //!< awake objects per update
+  };
+
   int mW, mH;
+  SimClock mClock;
   std::vector<std::shared_ptr<GameObject>> mObjects;
 
   std::vector<std::shared_ptr<GameObject>> mObjectsToAdd;
   std::vector<std::shared_ptr<GameObject>> mObjectsToRemove;
-  
+
+  //! \brief An object woken, and the set it is still in.
+  struct Waking {
+    std::uint32_t index;
+    GameObject::Activity from;
+  };
+
+  // indices in mObjects
+  std::vector<std::uint32_t> mAwake;
+  std::vector<std::uint32_t> mSleeping;
+  std::vector<std::uint32_t> mStatic;
+  std::vector<Waking> mWaking; //!< objects woken since the sets were last brought up to date
+  std::vector<std::uint32_t> mRested; //!< objects that came to rest or took another index since the last physics step; may hold indices gone stale since
+  std::vector<std::uint32_t> mJoinedAtRest; //!< objects added at rest since the influence map was last updated
+  std::uint64_t mPartitionVersion;
+
+  ProximitySensors mSensors;
+  SteeringBatch mSteering;
+  NavGrid mNavGrid;
+  FlowField mFlowField;
+  Pathfinder mPathfinder;
+  InfluenceMap mInfluence;
+  CoroutineScheduler mCoroutines;
+  AIScheduler mAI;
+  CollisionStage mCollisions;
+  SpatialIndex mSpatial;
+  LinearArena mScratch;
+
+  Blackboard mBlackboard;
+  InputManager mInput;
+  Random mRandom;
+
+  Metrics mMetrics;
+  std::vector<TagIndex> mTags; //!< few, so searched in order
+  unsigned mBehaviorTicks;
+
+  std::vector<SDL_Rect> mDirtyRects; //!< regions to clear and redraw on the next renderDirty
+  std::vector<std::uint32_t> mRedrawn; //!< indices of the objects overlapping one region, reused
+  bool mFullRedraw;
+
 };
 
 #endif
@@ -0,0 +1,292 @@
+#include "base/LevelFile.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char MAGIC[4] = { 'P', 'G', 'L', 'V' };
+
+LevelFile::LevelFile()
+    : mData(nullptr)
+    , mSize(0)
+    , mMapped(false)
+{
+}
+
+LevelFile::~LevelFile()
+{
+    close();
+}
+
+bool LevelFile::open(const char* path, std::string& error)
+{
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+    void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        error = std::string("cannot map ") + path;
+        return false;
+    }
+    mData = static_cast<const char*>(data);
+    mSize = size_t(st.st_size);
+    mMapped = true;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+    mBuffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    mData = mBuffer.data();
+    mSize = mBuffer.size();
+#endif
+
+    if (mSize < sizeof(MAGIC) || std::memcmp(mData, MAGIC, sizeof(MAGIC)) != 0) {
+        // the text form, compiled as it is read rather than ahead with levelc
+        std::istringstream in(std::string(mData, mSize));
+        std::vector<char> compiled;
+        if (!compileText(in, compiled, error)) {
+            error = std::string(path) + ": " + error;
+            close();
+            return false;
+        }
+        close();
+        mBuffer.swap(compiled);
+        mData = mBuffer.data();
+        mSize = mBuffer.size();
+    }
+
+    if (!validate(error)) {
+        error = std::string(path) + ": " + error;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LevelFile::close()
+{
+#ifndef _WIN32
+    if (mMapped) {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+#endif
+    mBuffer.clear();
+    mData = nullptr;
+    mSize = 0;
+    mMapped = false;
+}
+
+const char* LevelFile::kindName(std::uint32_t kind) const
+{
+    std::uint32_t offset;
+    std::memcpy(&offset, mData + header().kindsOffset + kind * sizeof(offset), sizeof(offset));
+    return string(offset);
+}
+
+const char* LevelFile::behaviorName(std::uint32_t behavior) const
+{
+    std::uint32_t offset;
+    std::memcpy(&offset, mData + header().behaviorsOffset + behavior * sizeof(offset), sizeof(offset));
+    return string(offset);
+}
+
+const char* LevelFile::string(std::uint32_t offset) const
+{
+    return mData + header().stringsOffset + offset;
+}
+
+bool LevelFile::validate(std::string& error) const
+{
+    if (mSize < sizeof(Header) || std::memcmp(header().magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "not a level file";
+        return false;
+    }
+    const Header& hdr = header();
+    if (hdr.version != VERSION) {
+        error = "unsupported version";
+        return false;
+    }
+
+    // every table inside the file, and aligned so records can be read in place
+    auto fits = [this](std::uint64_t offset, std::uint64_t bytes) { return offset % 4 == 0 && offset + bytes <= mSize; };
+    if (!fits(hdr.kindsOffset, std::uint64_t(hdr.kindCount) * 4)
+        || !fits(hdr.behaviorsOffset, std::uint64_t(hdr.behaviorCount) * 4)
+        || !fits(hdr.objectsOffset, std::uint64_t(hdr.objectCount) * sizeof(Object))
+        || std::uint64_t(hdr.stringsOffset) + hdr.stringsSize > mSize
+        || (hdr.stringsSize > 0 && mData[hdr.stringsOffset + hdr.stringsSize - 1] != '\0')) {
+        error = "truncated or corrupt tables";
+        return false;
+    }
+
+    for (std::uint32_t i = 0; i < hdr.kindCount + hdr.behaviorCount; ++i) {
+        std::uint32_t offset;
+        std::memcpy(&offset, mData + (i < hdr.kindCount ? hdr.kindsOffset + i * 4 : hdr.behaviorsOffset + (i - hdr.kindCount) * 4), 4);
+        if (offset >= hdr.stringsSize) {
+            error = "name outside the string table";
+            return false;
+        }
+    }
+
+    const Object* objs = objects();
+    for (std::uint32_t i = 0; i < hdr.objectCount; ++i) {
+        if (objs[i].kind < -1 || objs[i].kind >= std::int32_t(hdr.kindCount)
+            || objs[i].behavior < -1 || objs[i].behavior >= std::int32_t(hdr.behaviorCount)) {
+            error = "object " + std::to_string(i) + " refers to a missing kind or behavior";
+            return false;
+        }
+    }
+    return true;
+}
+
+// find name in the table, adding it if it is new
+static int intern(const std::string& name, std::unordered_map<std::string, int>& indices, std::vector<std::string>& names)
+{
+    auto elem = indices.find(name);
+    if (elem != indices.end()) {
+        return elem->second;
+    }
+    indices[name] = int(names.size());
+    names.push_back(name);
+    return int(names.size()) - 1;
+}
+
+template <typename T>
+static void append(std::vector<char>& out, const T& value)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+bool LevelFile::compileText(std::istream& in, std::vector<char>& out, std::string& error)
+{
+    Header hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+    hdr.version = VERSION;
+
+    bool sized = false;
+    std::unordered_map<std::string, int> kindIndices, behaviorIndices;
+    std::vector<std::string> kinds, behaviors;
+    std::vector<Object> objs;
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        std::istringstream words(line);
+        std::string first;
+        if (!(words >> first) || first[0] == '#') {
+            continue;
+        }
+        auto fail = [&](const std::string& what) {
+            error = "line " + std::to_string(lineNumber) + ": " + what;
+            return false;
+        };
+
+        if (first == "level") {
+            if (sized) {
+                return fail("more than one level line");
+            }
+            if (!(words >> hdr.w >> hdr.h) || hdr.w <= 0.0f || hdr.h <= 0.0f) {
+                return fail("expected level W H");
+            }
+            sized = true;
+            continue;
+        }
+        if (!sized) {
+            return fail("objects before the level line");
+        }
+
+        Object obj;
+        std::memset(&obj, 0, sizeof(obj));
+        if (!(words >> obj.tag >> obj.x >> obj.y >> obj.w >> obj.h)) {
+            return fail("expected KIND TAG X Y W H");
+        }
+        obj.kind = first == "-" ? -1 : std::int16_t(intern(first, kindIndices, kinds));
+        obj.behavior = -1;
+
+        std::string option;
+        while (words >> option) {
+            if (option[0] == '#') {
+                break;
+            } else if (option == "physics") {
+                obj.flags |= PHYSICS;
+            } else if (option == "solid") {
+                obj.flags |= PHYSICS | SOLID;
+            } else if (option.compare(0, 6, "color=") == 0 && option.size() == 12) {
+                unsigned long rgb = std::strtoul(option.c_str() + 6, nullptr, 16);
+                obj.flags |= RENDER;
+                obj.r = std::uint8_t(rgb >> 16);
+                obj.g = std::uint8_t(rgb >> 8);
+                obj.b = std::uint8_t(rgb);
+            } else if (option.compare(0, 9, "behavior=") == 0 && option.size() > 9) {
+                obj.behavior = std::int16_t(intern(option.substr(9), behaviorIndices, behaviors));
+            } else {
+                return fail("unknown option " + option);
+            }
+        }
+        if (kinds.size() > 0x7fff || behaviors.size() > 0x7fff) {
+            return fail("too many kinds or behaviors");
+        }
+        objs.push_back(obj);
+    }
+    if (!sized) {
+        error = "missing level line";
+        return false;
+    }
+
+    std::vector<char> strings;
+    std::vector<std::uint32_t> kindOffsets, behaviorOffsets;
+    for (const std::string& name : kinds) {
+        kindOffsets.push_back(std::uint32_t(strings.size()));
+        strings.insert(strings.end(), name.c_str(), name.c_str() + name.size() + 1);
+    }
+    for (const std::string& name : behaviors) {
+        behaviorOffsets.push_back(std::uint32_t(strings.size()));
+        strings.insert(strings.end(), name.c_str(), name.c_str() + name.size() + 1);
+    }
+
+    hdr.kindCount = std::uint32_t(kinds.size());
+    hdr.behaviorCount = std::uint32_t(behaviors.size());
+    hdr.objectCount = std::uint32_t(objs.size());
+    hdr.kindsOffset = sizeof(Header);
+    hdr.behaviorsOffset = hdr.kindsOffset + hdr.kindCount * 4;
+    hdr.objectsOffset = hdr.behaviorsOffset + hdr.behaviorCount * 4;
+    hdr.stringsOffset = hdr.objectsOffset + hdr.objectCount * std::uint32_t(sizeof(Object));
+    hdr.stringsSize = std::uint32_t(strings.size());
+
+    out.clear();
+    out.reserve(hdr.stringsOffset + hdr.stringsSize);
+    append(out, hdr);
+    for (std::uint32_t offset : kindOffsets) {
+        append(out, offset);
+    }
+    for (std::uint32_t offset : behaviorOffsets) {
+        append(out, offset);
+    }
+    const char* objBytes = reinterpret_cast<const char*>(objs.data());
+    out.insert(out.end(), objBytes, objBytes + objs.size() * sizeof(Object));
+    out.insert(out.end(), strings.begin(), strings.end());
+    return true;
+}
@@ -0,0 +1,93 @@
+#ifndef BASE_LEVEL_FILE
+#define BASE_LEVEL_FILE
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+//! \brief A level stored in the binary level format, memory mapped
+//! read-only. The file is a header, a table of kind names, a table of
+//! behavior names, a table of fixed-size object records, and the strings
+//! the name tables point into. Records can be used straight from the
+//! mapping, without parsing.
+//!
+//! Files are written in the byte order of the machine that compiled them;
+//! a file from a machine of the other order fails to open.
+class LevelFile {
+public:
+    static const std::uint32_t VERSION = 1;
+
+    //! \brief Component descriptor bits of an object record.
+    enum Flags : std::uint8_t {
+        PHYSICS = 1, //!< has a physics component
+        SOLID = 2, //!< the physics component is solid
+        RENDER = 4, //!< has a rect render component of the record's color
+    };
+
+    struct Header {
+        char magic[4]; //!< "PGLV"
+        std::uint32_t version;
+        float w, h; //!< level size
+        std::uint32_t kindCount, behaviorCount, objectCount;
+        std::uint32_t kindsOffset, behaviorsOffset, objectsOffset; //!< byte offsets of the tables from the start of the file
+        std::uint32_t stringsOffset, stringsSize; //!< the nul-terminated strings the tables refer to
+    };
+
+    //! \brief An object record.
+    struct Object {
+        float x, y, w, h;
+        std::int32_t tag;
+        std::int16_t kind; //!< index into the kind table, or -1 for a plain object built from the descriptors
+        std::int16_t behavior; //!< index into the behavior table, or -1 for none
+        std::uint8_t flags;
+        std::uint8_t r, g, b;
+    };
+
+    LevelFile();
+    ~LevelFile();
+
+    //! \brief Map a file and check it is a valid level. A file in the text
+    //! form (see compileText) is compiled as it is opened instead, which
+    //! costs a parse that a file compiled ahead with levelc does not.
+    bool open(const char* path, std::string& error);
+    void close();
+
+    inline float w() const { return header().w; }
+    inline float h() const { return header().h; }
+
+    inline std::uint32_t objectCount() const { return header().objectCount; }
+    inline const Object* objects() const { return reinterpret_cast<const Object*>(mData + header().objectsOffset); }
+
+    inline std::uint32_t kindCount() const { return header().kindCount; }
+    const char* kindName(std::uint32_t kind) const;
+
+    inline std::uint32_t behaviorCount() const { return header().behaviorCount; }
+    const char* behaviorName(std::uint32_t behavior) const;
+
+    //! \brief Compile the text form of a level into the binary format.
+    //!
+    //! Lines are blank, comments starting with #, or:
+    //!     level W H
+    //!     KIND TAG X Y W H [physics] [solid] [color=RRGGBB] [behavior=NAME]
+    //! where KIND is a kind name registered with the loader, or - for a
+    //! plain object built from the given components. The level line must
+    //! come first. On failure, error names the offending line.
+    static bool compileText(std::istream& in, std::vector<char>& out, std::string& error);
+
+private:
+    LevelFile(const LevelFile&) = delete;
+    void operator=(LevelFile const&) = delete;
+
+    inline const Header& header() const { return *reinterpret_cast<const Header*>(mData); }
+    const char* string(std::uint32_t offset) const;
+    bool validate(std::string& error) const;
+
+    const char* mData;
+    std::size_t mSize;
+    bool mMapped; //!< whether mData is a mapping rather than mBuffer
+    std::vector<char> mBuffer; //!< file contents where mapping is not available
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "base/LevelLoader.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include "base/Memory.hpp"
+#include "base/Pool.hpp"
+#include "base/RectRenderComponent.hpp"
+
+void LevelLoader::registerKind(const std::string& name, KindFactory factory)
+{
+    mKinds[name] = factory;
+}
+
+void LevelLoader::registerBehavior(const std::string& name, BehaviorFactory factory)
+{
+    mBehaviors[name] = factory;
+}
+
+std::shared_ptr<Level> LevelLoader::load(const char* path, std::string& error) const
+{
+    MemoryScope scope(Memory::LEVEL);
+    LevelFile file;
+    if (!file.open(path, error)) {
+        return nullptr;
+    }
+    std::shared_ptr<Level> level = std::make_shared<Level>(int(file.w()), int(file.h()));
+    if (!instantiate(file, *level, error)) {
+        return nullptr;
+    }
+    level->settle();
+    return level;
+}
+
+bool LevelLoader::instantiate(const LevelFile& file, Level& level, std::string& error) const
+{
+    // resolve the file's names once, so each record is a table lookup
+    std::vector<const KindFactory*> kinds(file.kindCount());
+    for (std::uint32_t i = 0; i < file.kindCount(); ++i) {
+        auto elem = mKinds.find(file.kindName(i));
+        if (elem == mKinds.end()) {
+            error = std::string("unknown kind ") + file.kindName(i);
+            return false;
+        }
+        kinds[i] = &elem->second;
+    }
+    std::vector<const BehaviorFactory*> behaviors(file.behaviorCount());
+    for (std::uint32_t i = 0; i < file.behaviorCount(); ++i) {
+        auto elem = mBehaviors.find(file.behaviorName(i));
+        if (elem == mBehaviors.end()) {
+            error = std::string("unknown behavior ") + file.behaviorName(i);
+            return false;
+        }
+        behaviors[i] = &elem->second;
+    }
+
+    std::vector<std::shared_ptr<GameObject>> objects;
+    objects.reserve(file.objectCount());
+    const LevelFile::Object* records = file.objects();
+    for (std::uint32_t i = 0; i < file.objectCount(); ++i) {
+        const LevelFile::Object& record = records[i];
+
+        std::shared_ptr<GameObject> obj;
+        if (record.kind >= 0) {
+            obj = (*kinds[record.kind])(record);
+            if (!obj) {
+                error = "kind " + std::string(file.kindName(record.kind)) + " made no object";
+                return false;
+            }
+        } else {
+            obj = makePooled<GameObject>(record.x, record.y, record.w, record.h, record.tag);
+        }
+
+        // the record's descriptors override what the kind made
+        if (record.flags & LevelFile::PHYSICS) {
+            const bool solid = (record.flags & LevelFile::SOLID) != 0;
+            std::shared_ptr<PhysicsComponent> physics = obj->physicsComponent();
+            if (!physics || physics->isSolid() != solid) {
+                obj->setPhysicsCompenent(makePooled<PhysicsComponent>(*obj, solid));
+            }
+        }
+        if (record.flags & LevelFile::RENDER) {
+            if (obj->renderComponent()) {
+                obj->setColor(record.r, record.g, record.b);
+            } else {
+                obj->setRenderCompenent(makePooled<RectRenderComponent>(*obj, record.r, record.g, record.b));
+            }
+        }
+        if (record.behavior >= 0) {
+            (*behaviors[record.behavior])(*obj);
+        }
+        objects.push_back(std::move(obj));
+    }
+
+    level.addObjects(objects);
+    return true;
+}
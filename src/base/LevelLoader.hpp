@@ -0,0 +1,42 @@
+#ifndef BASE_LEVEL_LOADER
+#define BASE_LEVEL_LOADER
+
+#include "base/LevelFile.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class GameObject;
+class Level;
+
+//! \brief Instantiates level files. Games register a factory for each kind
+//! of object their levels name, and for each behavior levels attach to
+//! objects; objects of kind - are plain game objects. The record's
+//! component descriptors apply to both: a kind's object gets the physics
+//! component and color its record asks for in place of its own.
+class LevelLoader {
+public:
+    //! \brief Makes an object of a kind from its record.
+    typedef std::function<std::shared_ptr<GameObject>(const LevelFile::Object&)> KindFactory;
+    //! \brief Adds a behavior (a behavior tree, state machine...) to an object.
+    typedef std::function<void(GameObject&)> BehaviorFactory;
+
+    void registerKind(const std::string& name, KindFactory factory);
+    void registerBehavior(const std::string& name, BehaviorFactory factory);
+
+    //! \brief Open a level file, binary or text, and make a level of its
+    //! size holding its objects, settled (see Level::settle) so the first
+    //! update costs no more than the ones after it. Returns null and sets
+    //! error on failure.
+    std::shared_ptr<Level> load(const char* path, std::string& error) const;
+
+    //! \brief Add all objects of an open file to a level, in file order.
+    bool instantiate(const LevelFile& file, Level& level, std::string& error) const;
+
+private:
+    std::unordered_map<std::string, KindFactory> mKinds;
+    std::unordered_map<std::string, BehaviorFactory> mBehaviors;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "base/LinearArena.hpp"
+#include <algorithm>
+#include <new>
+
+LinearArena::LinearArena(std::size_t blockSize)
+    : mCurrent(0)
+    , mOffset(0)
+    , mUsedBefore(0)
+{
+    mBlocks.push_back({ static_cast<char*>(::operator new(blockSize)), blockSize });
+}
+
+LinearArena::~LinearArena()
+{
+    for (Block& block : mBlocks) {
+        ::operator delete(block.data);
+    }
+}
+
+void* LinearArena::allocate(std::size_t size, std::size_t align)
+{
+    for (;;) {
+        Block& block = mBlocks[mCurrent];
+        std::size_t at = (reinterpret_cast<std::size_t>(block.data) + mOffset + align - 1) / align * align - reinterpret_cast<std::size_t>(block.data);
+        if (at + size <= block.size) {
+            mOffset = at + size;
+            return block.data + at;
+        }
+
+        // move on to the next block, adding one at least big enough
+        mUsedBefore += mOffset;
+        mOffset = 0;
+        if (++mCurrent == mBlocks.size()) {
+            std::size_t blockSize = std::max(mBlocks.back().size * 2, size + align);
+            mBlocks.push_back({ static_cast<char*>(::operator new(blockSize)), blockSize });
+        }
+    }
+}
+
+void LinearArena::reset()
+{
+    if (mBlocks.size() > 1) {
+        std::size_t total = 0;
+        for (Block& block : mBlocks) {
+            total += block.size;
+            ::operator delete(block.data);
+        }
+        mBlocks.clear();
+        mBlocks.push_back({ static_cast<char*>(::operator new(total)), total });
+    }
+    mCurrent = 0;
+    mOffset = 0;
+    mUsedBefore = 0;
+}
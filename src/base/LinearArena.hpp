@@ -0,0 +1,73 @@
+#ifndef BASE_LINEAR_ARENA
+#define BASE_LINEAR_ARENA
+
+#include <cstddef>
+#include <vector>
+
+//! \brief Bump-pointer memory for short-lived scratch data, all freed at
+//! once by reset. The level owns one and resets it at the end of every
+//! update, so anything built in it during a tick (collision lists and the
+//! like) costs no calls to the global allocator. When a tick needs more
+//! than the arena holds, it grows, and the next reset merges its blocks
+//! into one big enough for that tick.
+class LinearArena {
+public:
+    explicit LinearArena(std::size_t blockSize = 64 * 1024);
+    ~LinearArena();
+
+    void* allocate(std::size_t size, std::size_t align);
+    void reset(); //!< Free everything allocated since the last reset.
+
+    inline std::size_t used() const { return mUsedBefore + mOffset; } //!< Get the bytes handed out since the last reset, with padding.
+
+private:
+    LinearArena(const LinearArena&) = delete;
+    void operator=(LinearArena const&) = delete;
+
+    struct Block {
+        char* data;
+        std::size_t size;
+    };
+
+    std::vector<Block> mBlocks;
+    std::size_t mCurrent; //!< block being allocated from
+    std::size_t mOffset; //!< next free byte in the current block
+    std::size_t mUsedBefore; //!< bytes used in blocks before the current one
+};
+
+//! \brief A standard allocator drawing from a LinearArena; deallocation is
+//! a no-op until the arena is reset.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator(LinearArena& arena) noexcept
+        : mArena(&arena)
+    {
+    }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : mArena(other.arena())
+    {
+    }
+
+    T* allocate(std::size_t n) { return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, std::size_t) noexcept { }
+
+    inline LinearArena* arena() const { return mArena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return mArena == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return mArena != other.arena(); }
+
+private:
+    LinearArena* mArena;
+};
+
+//! \brief A vector in scratch memory; it must not outlive the arena's next reset.
+template <typename T>
+using ScratchVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,196 @@
+#include "base/Memory.hpp"
+#include "base/Stats.hpp"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+static const char* const NAMES[Memory::CATEGORIES] = { "other", "level", "physics", "ai", "render", "input" };
+
+const char* Memory::name(Category category)
+{
+    return NAMES[category];
+}
+
+#ifdef MEMORY_ACCOUNTING
+
+namespace {
+
+struct Account {
+    std::atomic<std::int64_t> bytes;
+    std::atomic<std::int64_t> peak;
+    std::atomic<std::uint64_t> allocations;
+};
+
+struct Header {
+    std::size_t size;
+    Memory::Category category;
+};
+static_assert(sizeof(Header) <= Memory::HEADER, "header does not fit");
+
+// constant-initialized, so they are ready before any static constructor allocates
+Account accounts[Memory::CATEGORIES];
+thread_local Memory::Category currentCategory = Memory::OTHER;
+
+struct ExitReport {
+    ~ExitReport() { Memory::report(std::cerr); }
+} exitReport;
+
+void* allocate(std::size_t size)
+{
+    void* raw = std::malloc(size + Memory::HEADER);
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    return Memory::track(raw, size);
+}
+
+void release(void* block)
+{
+    if (block) {
+        std::free(Memory::untrack(block));
+    }
+}
+
+}
+
+Memory::Category Memory::current()
+{
+    return currentCategory;
+}
+
+void Memory::setCurrent(Category category)
+{
+    currentCategory = category;
+}
+
+void* Memory::track(void* raw, std::size_t size)
+{
+    Header* header = static_cast<Header*>(raw);
+    header->size = size;
+    header->category = currentCategory;
+
+    Account& account = accounts[currentCategory];
+    account.allocations.fetch_add(1, std::memory_order_relaxed);
+    const std::int64_t bytes = account.bytes.fetch_add(std::int64_t(size), std::memory_order_relaxed) + std::int64_t(size);
+    std::int64_t peak = account.peak.load(std::memory_order_relaxed);
+    while (bytes > peak && !account.peak.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+    }
+    return static_cast<char*>(raw) + HEADER;
+}
+
+void* Memory::untrack(void* block)
+{
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(block) - HEADER);
+    accounts[header->category].bytes.fetch_sub(std::int64_t(header->size), std::memory_order_relaxed);
+    return header;
+}
+
+Memory::Usage Memory::usage(Category category)
+{
+    const Account& account = accounts[category];
+    return { account.bytes.load(std::memory_order_relaxed), account.peak.load(std::memory_order_relaxed),
+        account.allocations.load(std::memory_order_relaxed) };
+}
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    void* raw = std::malloc(size + Memory::HEADER);
+    return raw ? Memory::track(raw, size) : nullptr;
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* block) noexcept
+{
+    release(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    release(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    release(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept
+{
+    release(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept
+{
+    release(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept
+{
+    release(block);
+}
+
+#else
+
+Memory::Usage Memory::usage(Category)
+{
+    return { 0, 0, 0 };
+}
+
+#endif
+
+void Memory::report(std::ostream& out)
+{
+    if (!ENABLED) {
+        out << "memory accounting is not compiled in (define MEMORY_ACCOUNTING)" << std::endl;
+        return;
+    }
+    out << "memory by category (bytes now, peak bytes, allocations):" << std::endl;
+    for (int c = 0; c < CATEGORIES; ++c) {
+        const Usage used = usage(Category(c));
+        out << "  " << name(Category(c)) << ": " << used.bytes << ", " << used.peak << ", " << used.allocations << std::endl;
+    }
+}
+
+void Memory::publish()
+{
+    if (!ENABLED) {
+        return;
+    }
+    struct Gauges {
+        StatGauge* bytes;
+        StatGauge* peak;
+        StatGauge* allocations;
+    };
+    static const auto gauges = [] {
+        std::array<Gauges, CATEGORIES> gauges;
+        for (int c = 0; c < CATEGORIES; ++c) {
+            const std::string prefix = std::string("memory.") + name(Category(c));
+            gauges[c] = { &Stats::global().gauge(prefix + ".bytes"), &Stats::global().gauge(prefix + ".peak_bytes"),
+                &Stats::global().gauge(prefix + ".allocations") };
+        }
+        return gauges;
+    }();
+    for (int c = 0; c < CATEGORIES; ++c) {
+        const Usage used = usage(Category(c));
+        gauges[c].bytes->set(used.bytes);
+        gauges[c].peak->set(used.peak);
+        gauges[c].allocations->set(std::int64_t(used.allocations));
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef BASE_MEMORY
+#define BASE_MEMORY
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+//! \brief Memory accounting by subsystem, for sizing hosts for large
+//! worlds. Built with MEMORY_ACCOUNTING defined, every block from operator
+//! new or the Pool is charged to the category current on the thread that
+//! allocates it, and given back to that same category when freed, with a
+//! small header in front of the block to remember it. Totals are reported
+//! on standard error at exit. Built without it, nothing is counted, scopes
+//! compile away and every usage reads zero.
+//!
+//! The current category is set with a MemoryScope where a subsystem starts
+//! work, and by makePooled for types that name theirs in a static
+//! MEMORY_CATEGORY member.
+class Memory {
+public:
+#ifdef MEMORY_ACCOUNTING
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    enum Category {
+        OTHER,
+        LEVEL, //!< game objects, loading, the level's own bookkeeping
+        PHYSICS,
+        AI, //!< behavior trees, state machines, sensors, navigation
+        RENDER,
+        INPUT,
+        CATEGORIES
+    };
+
+    struct Usage {
+        std::int64_t bytes; //!< allocated now
+        std::int64_t peak; //!< most allocated at once
+        std::uint64_t allocations; //!< allocations made, freed or not
+    };
+
+    static const char* name(Category category);
+    static Usage usage(Category category);
+    static void report(std::ostream& out); //!< Write a line per category.
+    static void publish(); //!< Copy usage into Stats::global(), as memory.<category>.* gauges.
+
+#ifdef MEMORY_ACCOUNTING
+    static const std::size_t HEADER = 16; //!< bytes in front of each block; keeps the block 16-byte aligned
+
+    static Category current();
+    static void setCurrent(Category category);
+
+    //! \brief Charge a block of size bytes, given HEADER bytes more from
+    //! raw, to the current category, and get where the block starts.
+    static void* track(void* raw, std::size_t size);
+    static void* untrack(void* block); //!< Give a tracked block back to its category, and get its raw memory.
+#endif
+};
+
+//! \brief Charges the allocations made on this thread during its lifetime
+//! to a category, then goes back to the one before.
+class MemoryScope {
+public:
+#ifdef MEMORY_ACCOUNTING
+    explicit MemoryScope(Memory::Category category)
+        : mPrevious(Memory::current())
+    {
+        Memory::setCurrent(category);
+    }
+    ~MemoryScope() { Memory::setCurrent(mPrevious); }
+#else
+    explicit MemoryScope(Memory::Category) { }
+#endif
+
+private:
+    MemoryScope(const MemoryScope&) = delete;
+    void operator=(MemoryScope const&) = delete;
+
+#ifdef MEMORY_ACCOUNTING
+    Memory::Category mPrevious;
+#endif
+};
+
+#endif
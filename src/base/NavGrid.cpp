@@ -0,0 +1,92 @@
+#include "base/NavGrid.hpp"
+#include "base/GameObject.hpp"
+#include <algorithm>
+#include <cmath>
+
+const int NavGrid::STEP_DX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+const int NavGrid::STEP_DY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+const unsigned NavGrid::STEP_COST[8] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+
+NavGrid::NavGrid(int w, int h, float cellSize)
+    : mCols(std::max(1, int(std::ceil(w / cellSize))))
+    , mRows(std::max(1, int(std::ceil(h / cellSize))))
+    , mCellSize(cellSize)
+    , mVersion(0)
+    , mBlockers(size_t(mCols) * mRows, 0)
+{
+}
+
+int NavGrid::cellX(float x) const
+{
+    return std::min(std::max(int(std::floor(x / mCellSize)), 0), mCols - 1);
+}
+
+int NavGrid::cellY(float y) const
+{
+    return std::min(std::max(int(std::floor(y / mCellSize)), 0), mRows - 1);
+}
+
+void NavGrid::addObstacle(const GameObject& obj)
+{
+    if (mObstacles.count(&obj)) {
+        return;
+    }
+
+    // every cell the object's rectangle reaches into, not just touches
+    Footprint footprint;
+    footprint.x0 = int(std::floor(obj.x() / mCellSize));
+    footprint.y0 = int(std::floor(obj.y() / mCellSize));
+    footprint.x1 = int(std::ceil((obj.x() + obj.w()) / mCellSize)) - 1;
+    footprint.y1 = int(std::ceil((obj.y() + obj.h()) / mCellSize)) - 1;
+    footprint.x0 = std::max(footprint.x0, 0);
+    footprint.y0 = std::max(footprint.y0, 0);
+    footprint.x1 = std::min(footprint.x1, mCols - 1);
+    footprint.y1 = std::min(footprint.y1, mRows - 1);
+
+    mObstacles[&obj] = footprint;
+    addBlockers(footprint, 1);
+}
+
+void NavGrid::removeObstacle(const GameObject& obj)
+{
+    auto elem = mObstacles.find(&obj);
+    if (elem == mObstacles.end()) {
+        return;
+    }
+
+    addBlockers(elem->second, -1);
+    mObstacles.erase(elem);
+}
+
+bool NavGrid::isObstacle(const GameObject& obj)
+{
+    return obj.physicsComponent() && obj.physicsComponent()->isSolid() && !obj.hasGenericComponents();
+}
+
+void NavGrid::addBlockers(const Footprint& footprint, int delta)
+{
+    for (int cy = footprint.y0; cy <= footprint.y1; ++cy) {
+        for (int cx = footprint.x0; cx <= footprint.x1; ++cx) {
+            mBlockers[cy * mCols + cx] += delta;
+        }
+    }
+    ++mVersion;
+
+    for (Listener* listener : mListeners) {
+        listener->cellsChanged(footprint.x0, footprint.y0, footprint.x1, footprint.y1);
+    }
+}
+
+void NavGrid::addListener(Listener* listener)
+{
+    mListeners.push_back(listener);
+}
+
+void NavGrid::removeListener(Listener* listener)
+{
+    mListeners.erase(std::remove(mListeners.begin(), mListeners.end(), listener), mListeners.end());
+}
+
+NavGrid::Listener::~Listener()
+{
+}
@@ -0,0 +1,77 @@
+#ifndef BASE_NAV_GRID
+#define BASE_NAV_GRID
+
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+
+//! \brief A grid over the level recording which cells are blocked by
+//! obstacles, for navigation. Obstacles are the level's static solid objects
+//! (a solid physics component and no generic components); the level adds
+//! and removes them at its deferred add/remove point. A cell is blocked
+//! while any obstacle overlaps it.
+class NavGrid {
+public:
+    //! \brief Something that wants to know when cells change blocked state.
+    class Listener {
+    public:
+        virtual ~Listener();
+        virtual void cellsChanged(int x0, int y0, int x1, int y1) = 0; //!< called with the changed cells, inclusive
+    };
+
+    // the 8 steps to neighbouring cells; orthogonal steps first, with costs
+    // scaled so a diagonal step costs about sqrt(2) times an orthogonal one
+    static const int STEP_DX[8];
+    static const int STEP_DY[8];
+    static const unsigned STEP_COST[8];
+
+    NavGrid(int w, int h, float cellSize);
+
+    inline int cols() const { return mCols; }
+    inline int rows() const { return mRows; }
+    inline float cellSize() const { return mCellSize; }
+    inline unsigned version() const { return mVersion; } //!< Get a number that changes whenever a cell's blocked state does.
+
+    inline bool inBounds(int cx, int cy) const { return cx >= 0 && cy >= 0 && cx < mCols && cy < mRows; }
+    inline bool isBlocked(int cx, int cy) const { return !inBounds(cx, cy) || mBlockers[cy * mCols + cx] > 0; }
+
+    //! \brief Get if a step from a cell in the given direction is allowed:
+    //! the destination is open and a diagonal step cuts no blocked corner.
+    inline bool canStep(int cx, int cy, int dir) const
+    {
+        return !isBlocked(cx + STEP_DX[dir], cy + STEP_DY[dir])
+            && (dir < 4 || (!isBlocked(cx + STEP_DX[dir], cy) && !isBlocked(cx, cy + STEP_DY[dir])));
+    }
+
+    int cellX(float x) const; //!< Get the column containing x, clamped to the grid.
+    int cellY(float y) const; //!< Get the row containing y, clamped to the grid.
+    inline float centerX(int cx) const { return (cx + 0.5f) * mCellSize; }
+    inline float centerY(int cy) const { return (cy + 0.5f) * mCellSize; }
+
+    void addObstacle(const GameObject& obj); //!< Block the cells the object overlaps now.
+    void removeObstacle(const GameObject& obj); //!< Unblock the cells the object blocked.
+
+    static bool isObstacle(const GameObject& obj); //!< Determine if an object counts as an obstacle.
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    //! \brief The cells an obstacle was added over, inclusive.
+    struct Footprint {
+        int x0, y0, x1, y1;
+    };
+
+    void addBlockers(const Footprint& footprint, int delta);
+
+    int mCols, mRows;
+    float mCellSize;
+    unsigned mVersion;
+
+    std::vector<unsigned short> mBlockers; //!< number of obstacles overlapping each cell
+    std::unordered_map<const GameObject*, Footprint> mObstacles;
+    std::vector<Listener*> mListeners;
+};
+
+#endif
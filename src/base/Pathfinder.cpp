@@ -0,0 +1,712 @@
+#include "base/Pathfinder.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include "base/Steering.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+// open runs along a border at least this long get an entrance at each end
+// instead of one in the middle
+static const int LONG_ENTRANCE = 6;
+
+// the cost between two entrances with no path between them in their cluster
+static const unsigned NO_PATH = ~0u;
+
+// the search weighs the octile distance left by this over its denominator,
+// trading paths at most that much longer for far fewer nodes looked at
+static const unsigned HEURISTIC_WEIGHT = 6;
+static const unsigned HEURISTIC_SCALE = 5;
+
+// octile distance in step costs, never more than the real path cost
+static unsigned octile(int x0, int y0, int x1, int y1)
+{
+    const int dx = std::abs(x0 - x1);
+    const int dy = std::abs(y0 - y1);
+    return unsigned(NavGrid::STEP_COST[0] * std::max(dx, dy) + (NavGrid::STEP_COST[4] - NavGrid::STEP_COST[0]) * std::min(dx, dy));
+}
+
+Pathfinder::Pathfinder(NavGrid& grid, int clusterSize)
+    : mGrid(grid)
+    , mClusterSize(clusterSize)
+    , mClusterCols((grid.cols() + clusterSize - 1) / clusterSize)
+    , mClusterRows((grid.rows() + clusterSize - 1) / clusterSize)
+    , mGeneration(0)
+{
+    const int clusters = mClusterCols * mClusterRows;
+    mClusters.resize(clusters);
+    mEastBorders.resize(clusters);
+    mSouthBorders.resize(clusters);
+    for (int ii = 0; ii < clusters; ++ii) {
+        Cluster& cluster = mClusters[ii];
+        cluster.x0 = (ii % mClusterCols) * mClusterSize;
+        cluster.y0 = (ii / mClusterCols) * mClusterSize;
+        cluster.x1 = std::min(cluster.x0 + mClusterSize, mGrid.cols()) - 1;
+        cluster.y1 = std::min(cluster.y0 + mClusterSize, mGrid.rows()) - 1;
+        cluster.dirty = true;
+        mDirty.push_back(ii);
+    }
+
+    mGrid.addListener(this);
+}
+
+Pathfinder::~Pathfinder()
+{
+    mGrid.removeListener(this);
+}
+
+void Pathfinder::cellsChanged(int x0, int y0, int x1, int y1)
+{
+    // a change next to a border also changes the entrances across it
+    const int cx0 = std::max(x0 - 1, 0) / mClusterSize;
+    const int cy0 = std::max(y0 - 1, 0) / mClusterSize;
+    const int cx1 = std::min(x1 + 1, mGrid.cols() - 1) / mClusterSize;
+    const int cy1 = std::min(y1 + 1, mGrid.rows() - 1) / mClusterSize;
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            Cluster& cluster = mClusters[cy * mClusterCols + cx];
+            if (!cluster.dirty) {
+                cluster.dirty = true;
+                mDirty.push_back(cy * mClusterCols + cx);
+            }
+        }
+    }
+}
+
+bool Pathfinder::findPath(float sx, float sy, float gx, float gy, std::vector<Point>& path)
+{
+    path.clear();
+    update();
+
+    const int cols = mGrid.cols();
+    const int start = mGrid.cellY(sy) * cols + mGrid.cellX(sx);
+    const int goal = mGrid.cellY(gy) * cols + mGrid.cellX(gx);
+    if (mGrid.isBlocked(start % cols, start / cols) || mGrid.isBlocked(goal % cols, goal / cols)) {
+        return false;
+    }
+    if (start == goal) {
+        path.push_back({ gx, gy });
+        return true;
+    }
+
+    const int startCluster = clusterOf(start);
+    const int goalCluster = clusterOf(goal);
+    const Cluster& sc = mClusters[startCluster];
+    const Cluster& gc = mClusters[goalCluster];
+    mCells.clear();
+
+    // start and goal share a cluster: a path inside it is good enough
+    if (startCluster == goalCluster) {
+        mStartSearch.run(mGrid, sc.x0, sc.y0, sc.x1, sc.y1, start, goal);
+        if (mStartSearch.reached(goal, cols)) {
+            for (int cell = goal; cell != start; cell = mStartSearch.parent[mStartSearch.local(cell, cols)]) {
+                mCells.push_back(cell);
+            }
+            std::reverse(mCells.begin(), mCells.end());
+            smooth(start, mCells, gx, gy, path);
+            return true;
+        }
+    }
+
+    // link the start and goal to the entrances of their clusters, and give
+    // up unless they lead into the same part of the graph
+    mStartSearch.run(mGrid, sc.x0, sc.y0, sc.x1, sc.y1, start);
+    mGoalSearch.run(mGrid, gc.x0, gc.y0, gc.x1, gc.y1, goal);
+    const int maxNodes = nodesPerCluster();
+    bool connected = false;
+    for (int ii = 0; ii < int(sc.nodes.size()) && !connected; ++ii) {
+        if (!mStartSearch.reached(sc.nodes[ii].cell, cols)) {
+            continue;
+        }
+        for (int jj = 0; jj < int(gc.nodes.size()) && !connected; ++jj) {
+            connected = mGoalSearch.reached(gc.nodes[jj].cell, cols)
+                && mComponent[startCluster * maxNodes + ii] == mComponent[goalCluster * maxNodes + jj];
+        }
+    }
+    if (!connected) {
+        return false;
+    }
+
+    // A* over the entrances
+    const int startId = int(mClusters.size()) * maxNodes;
+    const int goalId = startId + 1;
+    if (++mGeneration == 0) {
+        std::fill(mStamp.begin(), mStamp.end(), 0);
+        mGeneration = 1;
+    }
+
+    mOpen.clear();
+    const int goalX = goal % cols;
+    const int goalY = goal / cols;
+    auto relax = [&](int id, unsigned cost, int from, int x, int y) {
+        if (mStamp[id] != mGeneration) {
+            mStamp[id] = mGeneration;
+            mCost[id] = cost;
+            mParent[id] = from;
+            const unsigned remaining = octile(x, y, goalX, goalY) * HEURISTIC_WEIGHT / HEURISTIC_SCALE;
+            mOpen.push_back({ cost + remaining, remaining, id });
+            siftUp(mOpen.size() - 1);
+        } else if (cost < mCost[id] && mOpenAt[id] >= 0) {
+            mCost[id] = cost;
+            mParent[id] = from;
+            Open& open = mOpen[mOpenAt[id]];
+            open.estimate = cost + open.remaining;
+            siftUp(mOpenAt[id]);
+        }
+    };
+
+    mStamp[startId] = mGeneration;
+    mCost[startId] = 0;
+    for (int ii = 0; ii < int(sc.nodes.size()); ++ii) {
+        if (mStartSearch.reached(sc.nodes[ii].cell, cols)) {
+            relax(startCluster * maxNodes + ii, mStartSearch.costTo(sc.nodes[ii].cell, cols), startId, sc.nodes[ii].x, sc.nodes[ii].y);
+        }
+    }
+
+    bool found = false;
+    while (!mOpen.empty()) {
+        const int id = mOpen.front().id;
+        mOpenAt[id] = -1;
+        mOpen.front() = mOpen.back();
+        mOpen.pop_back();
+        if (!mOpen.empty()) {
+            siftDown(0);
+        }
+        if (id == goalId) {
+            found = true;
+            break;
+        }
+
+        const int clusterId = id / maxNodes;
+        const Cluster& cluster = mClusters[clusterId];
+        const Node& node = cluster.nodes[id % maxNodes];
+        const unsigned cost = mCost[id];
+
+        if (clusterId == goalCluster && mGoalSearch.reached(node.cell, cols)) {
+            relax(goalId, cost + mGoalSearch.costTo(node.cell, cols), id, goalX, goalY);
+        }
+        for (const Edge& edge : node.edges) {
+            const Node& to = cluster.nodes[edge.to];
+            relax(clusterId * maxNodes + edge.to, cost + edge.cost, id, to.x, to.y);
+        }
+        for (int pp = 0; pp < node.partnerCount; ++pp) {
+            if (node.partnerNodes[pp] >= 0) {
+                // partners are one orthogonal step away
+                const int step = node.partners[pp] - node.cell;
+                relax(node.partnerNodes[pp], cost + NavGrid::STEP_COST[0], id, node.x + (step == 1) - (step == -1), node.y + (step == cols) - (step == -cols));
+            }
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    // walk back to the start, then splice the cell paths together
+    std::vector<int>& chain = mChain;
+    chain.clear();
+    for (int id = goalId; id != startId; id = mParent[id]) {
+        chain.push_back(id);
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    const Node& first = sc.nodes[chain.front() % maxNodes];
+    for (int cell = first.cell; cell != start; cell = mStartSearch.parent[mStartSearch.local(cell, cols)]) {
+        mCells.push_back(cell);
+    }
+    std::reverse(mCells.begin(), mCells.end());
+
+    for (size_t ii = 0; ii + 2 < chain.size(); ++ii) {
+        const Cluster& cluster = mClusters[chain[ii] / maxNodes];
+        const Node& node = cluster.nodes[chain[ii] % maxNodes];
+        if (chain[ii + 1] / maxNodes != chain[ii] / maxNodes) {
+            mCells.push_back(mClusters[chain[ii + 1] / maxNodes].nodes[chain[ii + 1] % maxNodes].cell);
+            continue;
+        }
+        for (const Edge& edge : node.edges) {
+            if (edge.to == chain[ii + 1] % maxNodes) {
+                mCells.insert(mCells.end(), cluster.paths.begin() + edge.path, cluster.paths.begin() + edge.path + edge.pathLength);
+                break;
+            }
+        }
+    }
+
+    const Node& last = gc.nodes[chain[chain.size() - 2] % maxNodes];
+    for (int cell = last.cell; cell != goal;) {
+        cell = mGoalSearch.parent[mGoalSearch.local(cell, cols)];
+        mCells.push_back(cell);
+    }
+
+    smooth(start, mCells, gx, gy, path);
+    return true;
+}
+
+int Pathfinder::findNode(const Cluster& cluster, int cell) const
+{
+    for (size_t ii = 0; ii < cluster.nodes.size(); ++ii) {
+        if (cluster.nodes[ii].cell == cell) {
+            return int(ii);
+        }
+    }
+    return -1;
+}
+
+void Pathfinder::update()
+{
+    if (mDirty.empty()) {
+        return;
+    }
+
+    // recompute the borders of the dirty clusters
+    for (int ii : mDirty) {
+        const int cx = ii % mClusterCols;
+        const int cy = ii / mClusterCols;
+        for (int bx = std::max(cx - 1, 0); bx <= cx; ++bx) {
+            if (bx + 1 < mClusterCols) {
+                const Cluster& cluster = mClusters[cy * mClusterCols + bx];
+                buildBorder(mEastBorders[cy * mClusterCols + bx], cluster.x1, cluster.y0, 0, 1, cluster.y1 - cluster.y0 + 1, 1, 0);
+            }
+        }
+        for (int by = std::max(cy - 1, 0); by <= cy; ++by) {
+            if (by + 1 < mClusterRows) {
+                const Cluster& cluster = mClusters[by * mClusterCols + cx];
+                buildBorder(mSouthBorders[by * mClusterCols + cx], cluster.x0, cluster.y1, 1, 0, cluster.x1 - cluster.x0 + 1, 0, 1);
+            }
+        }
+    }
+
+    // the dirty clusters and their neighbours now have different entrances
+    const std::vector<int> rebuild = withNeighbours(mDirty);
+    for (int ii : rebuild) {
+        buildCluster(ii);
+    }
+
+    // entrances of the rebuilt clusters moved, so their neighbours link again too
+    for (int ii : withNeighbours(rebuild)) {
+        linkCluster(ii);
+    }
+    label();
+
+    // the search state covers every node id and the start and goal, and is
+    // filled in here so the first query does not
+    const std::size_t ids = mClusters.size() * nodesPerCluster() + 2;
+    if (mStamp.size() < ids) {
+        mStamp.assign(ids, 0);
+        mCost.assign(ids, 0);
+        mParent.assign(ids, -1);
+        mOpenAt.assign(ids, -1);
+    }
+
+    mDirty.clear();
+}
+
+std::vector<int> Pathfinder::withNeighbours(const std::vector<int>& clusters) const
+{
+    std::vector<int> result;
+    for (int ii : clusters) {
+        const int cx = ii % mClusterCols;
+        const int cy = ii / mClusterCols;
+        result.push_back(ii);
+        if (cx > 0) {
+            result.push_back(ii - 1);
+        }
+        if (cx + 1 < mClusterCols) {
+            result.push_back(ii + 1);
+        }
+        if (cy > 0) {
+            result.push_back(ii - mClusterCols);
+        }
+        if (cy + 1 < mClusterRows) {
+            result.push_back(ii + mClusterCols);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void Pathfinder::buildBorder(std::vector<Transition>& transitions, int x, int y, int dx, int dy, int length, int acrossX, int acrossY)
+{
+    const int cols = mGrid.cols();
+    transitions.clear();
+
+    // find runs of cells open on both sides and put entrances on them
+    int runStart = -1;
+    for (int ii = 0; ii <= length; ++ii) {
+        const int ax = x + dx * ii;
+        const int ay = y + dy * ii;
+        const bool open = ii < length && !mGrid.isBlocked(ax, ay) && !mGrid.isBlocked(ax + acrossX, ay + acrossY);
+        if (open && runStart < 0) {
+            runStart = ii;
+        } else if (!open && runStart >= 0) {
+            const int runEnd = ii - 1;
+            auto add = [&](int at) {
+                const int cx = x + dx * at;
+                const int cy = y + dy * at;
+                transitions.push_back({ cy * cols + cx, (cy + acrossY) * cols + cx + acrossX });
+            };
+            if (runEnd - runStart + 1 >= LONG_ENTRANCE) {
+                add(runStart);
+                add(runEnd);
+            } else {
+                add((runStart + runEnd) / 2);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+void Pathfinder::buildCluster(int clusterId)
+{
+    Cluster& cluster = mClusters[clusterId];
+    const int cols = mGrid.cols();
+    const int cx = clusterId % mClusterCols;
+    const int cy = clusterId / mClusterCols;
+    cluster.nodes.clear();
+    cluster.paths.clear();
+    cluster.dirty = false;
+
+    // one node per entrance cell, however many borders it leads over
+    auto addEntrance = [&](int cell, int partner) {
+        int node = findNode(cluster, cell);
+        if (node < 0) {
+            node = int(cluster.nodes.size());
+            cluster.nodes.push_back({ cell, cell % cols, cell / cols, { -1, -1 }, { -1, -1 }, 0, {} });
+        }
+        Node& entry = cluster.nodes[node];
+        if (entry.partnerCount < 2) {
+            entry.partners[entry.partnerCount++] = partner;
+        }
+    };
+    if (cx + 1 < mClusterCols) {
+        for (const Transition& transition : mEastBorders[clusterId]) {
+            addEntrance(transition.a, transition.b);
+        }
+    }
+    if (cx > 0) {
+        for (const Transition& transition : mEastBorders[clusterId - 1]) {
+            addEntrance(transition.b, transition.a);
+        }
+    }
+    if (cy + 1 < mClusterRows) {
+        for (const Transition& transition : mSouthBorders[clusterId]) {
+            addEntrance(transition.a, transition.b);
+        }
+    }
+    if (cy > 0) {
+        for (const Transition& transition : mSouthBorders[clusterId - mClusterCols]) {
+            addEntrance(transition.b, transition.a);
+        }
+    }
+
+    // store the shortest path inside the cluster between every two entrances
+    for (int from = 0; from < int(cluster.nodes.size()); ++from) {
+        const int source = cluster.nodes[from].cell;
+        mBuildSearch.run(mGrid, cluster.x0, cluster.y0, cluster.x1, cluster.y1, source);
+        for (int to = 0; to < int(cluster.nodes.size()); ++to) {
+            const int target = cluster.nodes[to].cell;
+            if (to == from || !mBuildSearch.reached(target, cols)) {
+                continue;
+            }
+            const int path = int(cluster.paths.size());
+            for (int cell = target; cell != source; cell = mBuildSearch.parent[mBuildSearch.local(cell, cols)]) {
+                cluster.paths.push_back(cell);
+            }
+            std::reverse(cluster.paths.begin() + path, cluster.paths.end());
+            cluster.nodes[from].edges.push_back({ to, mBuildSearch.costTo(target, cols), path, int(cluster.paths.size()) - path });
+        }
+    }
+
+    // drop the paths as short through another entrance as they are direct;
+    // the search reaches the same costs with fewer edges to try
+    const int count = int(cluster.nodes.size());
+    mPairCost.assign(size_t(count) * count, NO_PATH);
+    for (int from = 0; from < count; ++from) {
+        for (const Edge& edge : cluster.nodes[from].edges) {
+            mPairCost[from * count + edge.to] = edge.cost;
+        }
+    }
+    for (int from = 0; from < count; ++from) {
+        std::vector<Edge>& edges = cluster.nodes[from].edges;
+        edges.erase(std::remove_if(edges.begin(), edges.end(), [&](const Edge& edge) {
+            for (int via = 0; via < count; ++via) {
+                const unsigned first = mPairCost[from * count + via];
+                const unsigned second = mPairCost[via * count + edge.to];
+                if (via != from && via != edge.to && first != NO_PATH && second != NO_PATH && first + second == edge.cost) {
+                    return true;
+                }
+            }
+            return false;
+        }),
+            edges.end());
+    }
+}
+
+void Pathfinder::linkCluster(int clusterId)
+{
+    for (Node& node : mClusters[clusterId].nodes) {
+        for (int pp = 0; pp < node.partnerCount; ++pp) {
+            const int partnerCluster = clusterOf(node.partners[pp]);
+            const int partner = findNode(mClusters[partnerCluster], node.partners[pp]);
+            node.partnerNodes[pp] = partner < 0 ? -1 : partnerCluster * nodesPerCluster() + partner;
+        }
+    }
+}
+
+void Pathfinder::label()
+{
+    const int maxNodes = nodesPerCluster();
+    mComponent.assign(mClusters.size() * maxNodes, -1);
+    std::vector<int> stack;
+    int next = 0;
+    for (int first = 0; first < int(mComponent.size()); ++first) {
+        if (mComponent[first] >= 0 || first % maxNodes >= int(mClusters[first / maxNodes].nodes.size())) {
+            continue;
+        }
+        mComponent[first] = next;
+        stack.assign(1, first);
+        while (!stack.empty()) {
+            const int id = stack.back();
+            stack.pop_back();
+            const Cluster& cluster = mClusters[id / maxNodes];
+            const Node& node = cluster.nodes[id % maxNodes];
+            auto visit = [&](int other) {
+                if (mComponent[other] < 0) {
+                    mComponent[other] = next;
+                    stack.push_back(other);
+                }
+            };
+            for (const Edge& edge : node.edges) {
+                visit(id - id % maxNodes + edge.to);
+            }
+            for (int pp = 0; pp < node.partnerCount; ++pp) {
+                if (node.partnerNodes[pp] >= 0) {
+                    visit(node.partnerNodes[pp]);
+                }
+            }
+        }
+        ++next;
+    }
+}
+
+void Pathfinder::siftUp(std::size_t at)
+{
+    const Open open = mOpen[at];
+    while (at > 0) {
+        const std::size_t parent = (at - 1) / 2;
+        if (!(open < mOpen[parent])) {
+            break;
+        }
+        mOpen[at] = mOpen[parent];
+        mOpenAt[mOpen[at].id] = int(at);
+        at = parent;
+    }
+    mOpen[at] = open;
+    mOpenAt[open.id] = int(at);
+}
+
+void Pathfinder::siftDown(std::size_t at)
+{
+    const Open open = mOpen[at];
+    for (;;) {
+        std::size_t child = 2 * at + 1;
+        if (child >= mOpen.size()) {
+            break;
+        }
+        if (child + 1 < mOpen.size() && mOpen[child + 1] < mOpen[child]) {
+            ++child;
+        }
+        if (!(mOpen[child] < open)) {
+            break;
+        }
+        mOpen[at] = mOpen[child];
+        mOpenAt[mOpen[at].id] = int(at);
+        at = child;
+    }
+    mOpen[at] = open;
+    mOpenAt[open.id] = int(at);
+}
+
+bool Pathfinder::lineOfSight(int from, int to) const
+{
+    // walk every cell the segment between the cell centers touches; passing
+    // exactly through a corner needs both cells beside it open
+    const int cols = mGrid.cols();
+    int x = from % cols;
+    int y = from / cols;
+    const int x1 = to % cols;
+    const int y1 = to / cols;
+    int dx = std::abs(x1 - x);
+    int dy = std::abs(y1 - y);
+    const int sx = x < x1 ? 1 : -1;
+    const int sy = y < y1 ? 1 : -1;
+    int error = dx - dy;
+    dx *= 2;
+    dy *= 2;
+    for (int n = 1 + (dx + dy) / 2; n > 0; --n) {
+        if (mGrid.isBlocked(x, y)) {
+            return false;
+        }
+        if (error > 0) {
+            x += sx;
+            error -= dy;
+        } else if (error < 0) {
+            y += sy;
+            error += dx;
+        } else {
+            if (n > 1 && (mGrid.isBlocked(x + sx, y) || mGrid.isBlocked(x, y + sy))) {
+                return false;
+            }
+            x += sx;
+            y += sy;
+            error += dx - dy;
+            --n;
+        }
+    }
+    return true;
+}
+
+void Pathfinder::smooth(int start, const std::vector<int>& cells, float gx, float gy, std::vector<Point>& path) const
+{
+    // keep only the cells where a straight line from the previous waypoint
+    // stops working; long straight runs are cut so each check stays short
+    const int cols = mGrid.cols();
+    const int reach = 2 * mClusterSize;
+    int anchor = start;
+    for (size_t ii = 0; ii + 1 < cells.size(); ++ii) {
+        const int next = cells[ii + 1];
+        const bool far = std::abs(next % cols - anchor % cols) > reach || std::abs(next / cols - anchor / cols) > reach;
+        if (far || !lineOfSight(anchor, next)) {
+            path.push_back({ mGrid.centerX(cells[ii] % cols), mGrid.centerY(cells[ii] / cols) });
+            anchor = cells[ii];
+        }
+    }
+    path.push_back({ gx, gy });
+}
+
+void Pathfinder::LocalSearch::run(const NavGrid& grid, int bx0, int by0, int bx1, int by1, int source, int stopAt)
+{
+    const int cols = grid.cols();
+    x0 = bx0;
+    y0 = by0;
+    w = bx1 - bx0 + 1;
+    h = by1 - by0 + 1;
+    if (stamp.size() < size_t(w) * h) {
+        stamp.assign(size_t(w) * h, 0);
+        cost.resize(size_t(w) * h);
+        parent.resize(size_t(w) * h);
+    }
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+
+    // Dijkstra with a bucket per cost: steps cost so little that the
+    // buckets can be reused round a ring instead of keeping a heap
+    const unsigned ring = sizeof(buckets) / sizeof(buckets[0]);
+    for (std::vector<int>& bucket : buckets) {
+        bucket.clear();
+    }
+    stamp[local(source, cols)] = generation;
+    cost[local(source, cols)] = 0;
+    parent[local(source, cols)] = -1;
+    buckets[0].push_back(source);
+    std::size_t pending = 1;
+    for (unsigned cellCost = 0; pending > 0; ++cellCost) {
+        std::vector<int>& bucket = buckets[cellCost % ring];
+        for (std::size_t kk = 0; kk < bucket.size(); ++kk) {
+            const int cell = bucket[kk];
+            --pending;
+            if (cellCost != cost[local(cell, cols)]) {
+                continue;
+            }
+            if (cell == stopAt) {
+                return;
+            }
+
+            const int cx = cell % cols;
+            const int cy = cell / cols;
+            for (int dir = 0; dir < 8; ++dir) {
+                const int nx = cx + NavGrid::STEP_DX[dir];
+                const int ny = cy + NavGrid::STEP_DY[dir];
+                if (nx < bx0 || ny < by0 || nx > bx1 || ny > by1 || !grid.canStep(cx, cy, dir)) {
+                    continue;
+                }
+                const int neighbor = ny * cols + nx;
+                const int l = local(neighbor, cols);
+                const unsigned neighborCost = cellCost + NavGrid::STEP_COST[dir];
+                if (stamp[l] != generation || neighborCost < cost[l]) {
+                    stamp[l] = generation;
+                    cost[l] = neighborCost;
+                    parent[l] = cell;
+                    buckets[neighborCost % ring].push_back(neighbor);
+                    ++pending;
+                }
+            }
+        }
+        bucket.clear();
+    }
+}
+
+bool Pathfinder::LocalSearch::reached(int cell, int cols) const
+{
+    const int cx = cell % cols - x0;
+    const int cy = cell / cols - y0;
+    return cx >= 0 && cy >= 0 && cx < w && cy < h && stamp[cy * w + cx] == generation;
+}
+
+unsigned Pathfinder::LocalSearch::costTo(int cell, int cols) const
+{
+    return cost[local(cell, cols)];
+}
+
+PathFollower::PathFollower()
+    : mNext(0)
+    , mPlanned(false)
+    , mGoalX(0.0f)
+    , mGoalY(0.0f)
+    , mGridVersion(0)
+{
+}
+
+void PathFollower::reset()
+{
+    mPath.clear();
+    mNext = 0;
+    mPlanned = false;
+}
+
+PathFollower::Result PathFollower::step(Level& level, GameObject& gameObject, float x, float y, float speed)
+{
+    // paths are planned between object centers
+    const float halfW = gameObject.w() * 0.5f;
+    const float halfH = gameObject.h() * 0.5f;
+
+    const unsigned version = level.navGrid().version();
+    if (!mPlanned || x != mGoalX || y != mGoalY || version != mGridVersion) {
+        mPlanned = true;
+        mGoalX = x;
+        mGoalY = y;
+        mGridVersion = version;
+        mNext = 0;
+        if (!level.pathfinder().findPath(gameObject.x() + halfW, gameObject.y() + halfH, x + halfW, y + halfH, mPath)) {
+            mPath.clear();
+        }
+    }
+
+    if (mPath.empty()) {
+        return Result::NO_PATH;
+    }
+    if (mNext >= mPath.size()) {
+        return Result::ARRIVED;
+    }
+
+    const bool last = mNext + 1 == mPath.size();
+    const float tx = last ? x : mPath[mNext].x - halfW;
+    const float ty = last ? y : mPath[mNext].y - halfH;
+    if (moveToward(gameObject, tx, ty, speed)) {
+        ++mNext;
+        if (last) {
+            return Result::ARRIVED;
+        }
+    }
+    return Result::MOVING;
+}
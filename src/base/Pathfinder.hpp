@@ -0,0 +1,172 @@
+#ifndef BASE_PATHFINDER
+#define BASE_PATHFINDER
+
+#include "base/NavGrid.hpp"
+#include <cstddef>
+#include <vector>
+
+class GameObject;
+class Level;
+
+//! \brief Finds paths across the level's NavGrid with hierarchical A*
+//! (HPA*). The grid is cut into square clusters; open cells facing each other
+//! across a cluster border become entrance nodes, and the shortest path
+//! between every two entrances of a cluster is stored, unless it is as
+//! short through a third. A query links the
+//! start and goal into their clusters, searches this small abstract graph,
+//! splices the stored paths together and smooths the result with
+//! line-of-sight checks. The search overestimates the distance left a
+//! little, so it finds a path at most a fifth longer than the best one
+//! through the entrances while looking at far fewer of them, and it knows
+//! at once when start and goal are not connected. When obstacles change, only the clusters around
+//! them are rebuilt.
+class Pathfinder : public NavGrid::Listener {
+public:
+    //! \brief A point on a path, in level coordinates.
+    struct Point {
+        float x, y;
+    };
+
+    Pathfinder(NavGrid& grid, int clusterSize = 16);
+    virtual ~Pathfinder();
+
+    //! \brief Find a path from (sx, sy) to (gx, gy). On success path holds
+    //! the waypoints after the start: centers of the cells where the path
+    //! turns, then the goal itself.
+    bool findPath(float sx, float sy, float gx, float gy, std::vector<Point>& path);
+
+    //! \brief Rebuild the clusters around obstacles added or removed since
+    //! the last call. The level does this at the start of each update, so
+    //! the first query after a load or a change does not pay for it.
+    void update();
+
+    virtual void cellsChanged(int x0, int y0, int x1, int y1) override;
+
+private:
+    Pathfinder(const Pathfinder&) = delete;
+    void operator=(Pathfinder const&) = delete;
+
+    //! \brief A stored shortest path from one entrance to another in the same cluster.
+    struct Edge {
+        int to; //!< index of the destination node in the cluster
+        unsigned cost;
+        int path; //!< offset of the path cells in the cluster's path pool, excluding the source and including the destination
+        int pathLength;
+    };
+
+    //! \brief An entrance: an open cell next to an open cell of a neighbouring cluster.
+    struct Node {
+        int cell;
+        int x, y; //!< column and row of the cell
+        int partners[2]; //!< cells across the borders this entrance leads over
+        int partnerNodes[2]; //!< ids of the entrances on those cells, or -1
+        int partnerCount;
+        std::vector<Edge> edges;
+    };
+
+    struct Cluster {
+        int x0, y0, x1, y1; //!< cells covered, inclusive
+        std::vector<Node> nodes;
+        std::vector<int> paths;
+        bool dirty;
+    };
+
+    //! \brief Two facing open cells on a border between clusters.
+    struct Transition {
+        int a, b;
+    };
+
+    //! \brief A node waiting in the open list. Of two with the same
+    //! estimate the one nearer the goal goes first, so the search follows
+    //! one of the many equally short paths instead of widening over all.
+    struct Open {
+        unsigned estimate; //!< cost so far plus the heuristic
+        unsigned remaining; //!< the heuristic
+        int id;
+        inline bool operator<(const Open& other) const
+        {
+            return estimate != other.estimate ? estimate < other.estimate : remaining < other.remaining;
+        }
+    };
+
+    //! \brief Dijkstra over the cells of one rectangle, reusable without clearing.
+    struct LocalSearch {
+        int x0 = 0, y0 = 0, w = 0, h = 0;
+        unsigned generation = 0;
+        std::vector<unsigned> stamp, cost;
+        std::vector<int> parent; //!< global cell each cell was reached from
+        std::vector<int> buckets[16]; //!< cells to visit by cost, modulo more than the largest step cost
+
+        void run(const NavGrid& grid, int x0, int y0, int x1, int y1, int source, int stopAt = -1);
+        inline int local(int cell, int cols) const { return (cell / cols - y0) * w + cell % cols - x0; }
+        bool reached(int cell, int cols) const;
+        unsigned costTo(int cell, int cols) const;
+    };
+
+    inline int clusterOf(int cell) const { return (cell / mGrid.cols() / mClusterSize) * mClusterCols + (cell % mGrid.cols()) / mClusterSize; }
+    int findNode(const Cluster& cluster, int cell) const;
+    inline int nodesPerCluster() const { return 4 * mClusterSize; } //!< Get the most entrances a cluster can have; node ids are cluster * nodesPerCluster + index.
+
+    std::vector<int> withNeighbours(const std::vector<int>& clusters) const; //!< Get clusters and the clusters next to them, each once.
+    void buildBorder(std::vector<Transition>& transitions, int x, int y, int dx, int dy, int length, int acrossX, int acrossY);
+    void buildCluster(int cluster);
+    void linkCluster(int cluster); //!< Find the entrances across the borders of a cluster.
+    void label(); //!< Number the connected parts of the graph of entrances.
+
+    // the open list is a binary heap holding each node once, so a cheaper
+    // way to a node moves it up instead of adding another entry
+    void siftUp(std::size_t at);
+    void siftDown(std::size_t at);
+
+    bool lineOfSight(int from, int to) const;
+    void smooth(int start, const std::vector<int>& cells, float gx, float gy, std::vector<Point>& path) const;
+
+    NavGrid& mGrid;
+    const int mClusterSize;
+    int mClusterCols, mClusterRows;
+
+    std::vector<Cluster> mClusters;
+    std::vector<std::vector<Transition>> mEastBorders; //!< transitions from each cluster to its east neighbour
+    std::vector<std::vector<Transition>> mSouthBorders; //!< transitions from each cluster to its south neighbour
+    std::vector<int> mDirty; //!< dirty clusters
+    std::vector<int> mComponent; //!< connected part of the graph each node is in, by node id
+
+    // scratch for queries and rebuilds
+    LocalSearch mBuildSearch, mStartSearch, mGoalSearch;
+    std::vector<unsigned> mStamp, mCost;
+    std::vector<int> mParent;
+    std::vector<int> mOpenAt; //!< where each node is in mOpen, or -1 once expanded
+    unsigned mGeneration;
+    std::vector<Open> mOpen;
+    std::vector<unsigned> mPairCost; //!< costs between the entrances of the cluster being built
+    std::vector<int> mChain; //!< abstract nodes on the path found
+    std::vector<int> mCells; //!< cells on the path found
+};
+
+//! \brief Moves an object along paths from the level's pathfinder toward a
+//! point, replanning when the goal or the obstacles change.
+class PathFollower {
+public:
+    enum class Result {
+        MOVING,
+        ARRIVED,
+        NO_PATH,
+    };
+
+    PathFollower();
+
+    void reset(); //!< Forget the current path.
+
+    //! \brief Move the object one step at speed toward having its top left
+    //! corner at (x, y), as moveToward would.
+    Result step(Level& level, GameObject& gameObject, float x, float y, float speed);
+
+private:
+    std::vector<Pathfinder::Point> mPath;
+    std::size_t mNext;
+    bool mPlanned;
+    float mGoalX, mGoalY;
+    unsigned mGridVersion;
+};
+
+#endif
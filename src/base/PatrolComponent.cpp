@@ -1,5 +1,6 @@
 #include "base/PatrolComponent.hpp"
 #include "base/GameObject.hpp"
+#include "base/Snapshot.hpp"
 #include <cmath>
 
 PatrolComponent::PatrolComponent(GameObject & gameObject, float toX, float toY, float speed):
@@ -30,3 +31,17 @@ PatrolComponent::update(Level & level)
     mForward = !mForward;
   }
 }
+
+void
+PatrolComponent::save(Snapshot & snapshot) const
+{
+  snapshot.write(mStep);
+  snapshot.write(mForward);
+}
+
+void
+PatrolComponent::load(SnapshotReader & reader)
+{
+  reader.read(mStep);
+  reader.read(mForward);
+}
@@ -11,6 +11,9 @@ public:
   
   virtual void update(Level & level);
 
+  virtual void save(Snapshot & snapshot) const override;
+  virtual void load(SnapshotReader & reader) override;
+
 private:
 
   float mDX, mDY;
@@ -1,71 +1,122 @@
 #include "base/PhysicsComponent.hpp"
+#include "base/CollisionLayers.hpp"
+#include "base/CollisionStage.hpp"
 #include "base/GameObject.hpp"
-#include "base/Level.hpp"
+#include "base/Snapshot.hpp"
 #include <cmath>
 
 PhysicsComponent::PhysicsComponent(GameObject & gameObject, bool solid):
   Component(gameObject),
   mSolid(solid),
+  mLayer(0),
+  mMask(~std::uint32_t(0)),
   mVx(0.0f),
   mVy(0.0f)
 {
 }
 
+void
+PhysicsComponent::setLayer(unsigned layer)
+{
+  if (layer < CollisionLayers::LAYERS) {
+    mLayer = layer;
+  }
+}
+
+void
+PhysicsComponent::setVx(float vx)
+{
+  mVx = vx;
+  if (vx != 0.0f) {
+    getGameObject().wake();
+  }
+}
+
+void
+PhysicsComponent::setVy(float vy)
+{
+  mVy = vy;
+  if (vy != 0.0f) {
+    getGameObject().wake();
+  }
+}
+
 void
 PhysicsComponent::step(Level & level)
 {
   GameObject & gameObject = getGameObject();
 
-  float oldX = gameObject.x();
-  float oldY = gameObject.y();
-
   gameObject.setX(gameObject.x() + mVx);
   gameObject.setY(gameObject.y() + mVy);
+}
 
-  if (!mSolid) {
-    std::vector<std::shared_ptr<GameObject>> objects;
-    if (level.getCollisions(gameObject, objects)) {
-      for (auto obj: objects) {
-	if (obj->physicsComponent()) {
-	  if (obj->physicsComponent()->isSolid()) {
-	    if (!gameObject.isColliding(*obj)) {
-	      continue;
-	    }
+void
+PhysicsComponent::resolve(const GameObject & obj, float oldX, float oldY)
+{
+  GameObject & gameObject = getGameObject();
 
-	    float resolveX = 0.0f;
-	    if (oldX < obj->x() && mVx > 0.0f) {
-	      resolveX = -(gameObject.x() - (obj->x() - gameObject.w()));
-	    } else if (oldX > obj->x() && mVx < 0.0f) {
-	      resolveX = (obj->x() - (gameObject.x() - obj->w()));
-	    }
+  if (!gameObject.isColliding(obj)) {
+    // passed through it during the step: stop at the face reached first
+    CollisionStage::Box from = { oldX, oldY, gameObject.w(), gameObject.h() };
+    CollisionStage::Box box = { obj.x(), obj.y(), obj.w(), obj.h() };
+    float dx = gameObject.x() - oldX;
+    float dy = gameObject.y() - oldY;
+    float time;
+    bool xAxis;
+    if (!CollisionStage::sweep(from, dx, dy, box, time, xAxis)) {
+      return;
+    }
+    if (xAxis) {
+      gameObject.setX(dx > 0.0f ? obj.x() - gameObject.w() : obj.x() + obj.w());
+      mVx = 0;
+    } else {
+      gameObject.setY(dy > 0.0f ? obj.y() - gameObject.h() : obj.y() + obj.h());
+      mVy = 0;
+    }
+    return;
+  }
+
+  float resolveX = 0.0f;
+  if (oldX < obj.x() && mVx > 0.0f) {
+    resolveX = -(gameObject.x() - (obj.x() - gameObject.w()));
+  } else if (oldX > obj.x() && mVx < 0.0f) {
+    resolveX = (obj.x() - (gameObject.x() - obj.w()));
+  }
 
-	    float resolveY = 0.0f;
-	    if (oldY < obj->y() && mVy > 0.0f) {
-	      resolveY = -(gameObject.y() - (obj->y() - gameObject.h()));
-	    } else if (oldY > obj->y() && mVy < 0.0f) {
-	      resolveY = (obj->y() - (gameObject.y() - obj->h()));
-	    }
+  float resolveY = 0.0f;
+  if (oldY < obj.y() && mVy > 0.0f) {
+    resolveY = -(gameObject.y() - (obj.y() - gameObject.h()));
+  } else if (oldY > obj.y() && mVy < 0.0f) {
+    resolveY = (obj.y() - (gameObject.y() - obj.h()));
+  }
 
-	    if (resolveX != 0.0f && resolveY != 0.0f) {
-	      if (fabsf(resolveX) < fabsf(resolveY)) {
-		gameObject.setX(gameObject.x() + resolveX);
-		mVx = 0;
-	      } else {
-		gameObject.setY(gameObject.y() + resolveY);
-		mVy = 0;
-	      }
-	    } else if (resolveX != 0.0f) {
-	      gameObject.setX(gameObject.x() + resolveX);
-	      mVx = 0;
-	    } else if (resolveY != 0.0f) {
-	      gameObject.setY(gameObject.y() + resolveY);
-	      mVy = 0;
-	    }
-	  } else {
-	    gameObject.collision(level, obj);
-	  }
-	}
-      }
+  if (resolveX != 0.0f && resolveY != 0.0f) {
+    if (fabsf(resolveX) < fabsf(resolveY)) {
+      gameObject.setX(gameObject.x() + resolveX);
+      mVx = 0;
+    } else {
+      gameObject.setY(gameObject.y() + resolveY);
+      mVy = 0;
     }
+  } else if (resolveX != 0.0f) {
+    gameObject.setX(gameObject.x() + resolveX);
+    mVx = 0;
+  } else if (resolveY != 0.0f) {
+    gameObject.setY(gameObject.y() + resolveY);
+    mVy = 0;
   }
 }
+
+void
+PhysicsComponent::save(Snapshot & snapshot) const
+{
+  snapshot.write(mVx);
+  snapshot.write(mVy);
+}
+
+void
+PhysicsComponent::load(SnapshotReader & reader)
+{
+  reader.read(mVx);
+  reader.read(mVy);
+}
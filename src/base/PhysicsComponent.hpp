@@ -2,31 +2,52 @@
 #define BASE_PHYSICS_COMPONENT
 
 #include "base/Component.hpp"
+#include "base/Memory.hpp"
+#include <cstdint>
 #include <memory>
 
 class Level;
+class Snapshot;
+class SnapshotReader;
 
 //! \brief A component for handling simple physics. Has a velocity and
 //! a solid property.  Solid objects prevent non-solid objects from
 //! moving through them, and non-solid objects can collide with each
-//! other.
+//! other; the level's CollisionStage finds and handles the contacts.
+//!
+//! A body is on a collision layer, and only touches bodies on the layers
+//! the level's CollisionLayers lets its layer interact with and its own
+//! mask allows.
 class PhysicsComponent: public Component {
 public:
 
+  static constexpr Memory::Category MEMORY_CATEGORY = Memory::PHYSICS; //!< what makePooled charges physics components to
+
   PhysicsComponent(GameObject & gameObject, bool solid);
 
   inline bool isSolid() const { return mSolid; }
+
+  inline unsigned layer() const { return mLayer; }
+  void setLayer(unsigned layer); //!< Put the body on a collision layer, below CollisionLayers::LAYERS; others are ignored.
+  inline std::uint32_t mask() const { return mMask; }
+  inline void setMask(std::uint32_t mask) { mMask = mask; } //!< Set the layers this body may touch, one bit each, on top of the level's matrix; all by default.
   
   inline float vx() const { return mVx; }
   inline float vy() const { return mVy; }
-  inline void setVx(float vx) { mVx = vx; }
-  inline void setVy(float vy) { mVy = vy; }
+  void setVx(float vx); //!< Set the horizontal velocity, waking the object if it is not zero.
+  void setVy(float vy); //!< Set the vertical velocity, waking the object if it is not zero.
   
-  void step(Level & level); //!< Step the physics.
+  void step(Level & level); //!< Move by the velocity.
+  void resolve(const GameObject & obj, float oldX, float oldY); //!< Push the object out of, or stop it short of, a solid object it moved into from (oldX, oldY).
+
+  void save(Snapshot & snapshot) const; //!< Write the velocity to a snapshot.
+  void load(SnapshotReader & reader); //!< Read back what save wrote.
 
 private:
 
   bool mSolid;
+  unsigned mLayer;
+  std::uint32_t mMask;
   float mVx, mVy;
 
 };
@@ -0,0 +1,105 @@
+#include "base/Pool.hpp"
+#include <cstdlib>
+
+namespace {
+
+const std::size_t CLASSES = Pool::MAX_SIZE / Pool::GRANULE;
+const std::size_t CHUNK_SIZE = 64 * 1024;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// trivially destructible, so it stays usable while the thread's other
+// thread-locals and, for the main thread, statics are being destroyed
+struct FreeLists {
+    FreeBlock* heads[CLASSES];
+};
+
+thread_local FreeLists freeLists = {};
+thread_local std::uint64_t allocated = 0;
+
+inline std::size_t classOf(std::size_t size)
+{
+    return (size + Pool::GRANULE - 1) / Pool::GRANULE - 1;
+}
+
+// carve a new chunk into blocks of a class and put them on its list
+void refill(std::size_t sizeClass)
+{
+    const std::size_t blockSize = (sizeClass + 1) * Pool::GRANULE;
+#ifdef MEMORY_ACCOUNTING
+    // the blocks are charged as they are handed out, not the chunk
+    char* chunk = static_cast<char*>(std::malloc(CHUNK_SIZE));
+    if (!chunk) {
+        throw std::bad_alloc();
+    }
+#else
+    char* chunk = static_cast<char*>(::operator new(CHUNK_SIZE));
+#endif
+    FreeBlock* head = freeLists.heads[sizeClass];
+    for (std::size_t at = CHUNK_SIZE / blockSize * blockSize; at != 0;) {
+        at -= blockSize;
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + at);
+        block->next = head;
+        head = block;
+    }
+    freeLists.heads[sizeClass] = head;
+}
+
+// the bytes a block of a size takes from its class, with room for the
+// accounting header when there is one
+inline std::size_t pooledSize(std::size_t size)
+{
+#ifdef MEMORY_ACCOUNTING
+    return size + Memory::HEADER;
+#else
+    return size;
+#endif
+}
+
+}
+
+void* Pool::allocate(std::size_t size)
+{
+    ++allocated;
+    if (size == 0 || pooledSize(size) > MAX_SIZE) {
+        return ::operator new(size);
+    }
+
+    const std::size_t sizeClass = classOf(pooledSize(size));
+    if (!freeLists.heads[sizeClass]) {
+        refill(sizeClass);
+    }
+    FreeBlock* block = freeLists.heads[sizeClass];
+    freeLists.heads[sizeClass] = block->next;
+#ifdef MEMORY_ACCOUNTING
+    return Memory::track(block, size);
+#else
+    return block;
+#endif
+}
+
+void Pool::deallocate(void* block, std::size_t size) noexcept
+{
+    if (!block) {
+        return;
+    }
+    if (size == 0 || pooledSize(size) > MAX_SIZE) {
+        ::operator delete(block);
+        return;
+    }
+
+#ifdef MEMORY_ACCOUNTING
+    block = Memory::untrack(block);
+#endif
+    const std::size_t sizeClass = classOf(pooledSize(size));
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = freeLists.heads[sizeClass];
+    freeLists.heads[sizeClass] = freed;
+}
+
+std::uint64_t Pool::allocations()
+{
+    return allocated;
+}
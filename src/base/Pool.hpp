@@ -0,0 +1,67 @@
+#ifndef BASE_POOL
+#define BASE_POOL
+
+#include "base/Memory.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+//! \brief Recycling memory for small, frequently made objects: game
+//! objects, components, behavior nodes. Sizes are rounded up to 16-byte
+//! classes, and each thread keeps a free list per class, carved out of large
+//! chunks. A freed block goes back on the list of the thread that frees it,
+//! ready for the next object of that size, so once warmed up making and
+//! dropping objects never reaches the global allocator. Chunks are kept for
+//! reuse and never returned. Larger sizes fall through to operator new.
+class Pool {
+public:
+    static const std::size_t GRANULE = 16; //!< size classes are multiples of this, which is also the alignment
+    static const std::size_t MAX_SIZE = 512; //!< largest pooled size
+
+    static void* allocate(std::size_t size);
+    static void deallocate(void* block, std::size_t size) noexcept;
+
+    static std::uint64_t allocations(); //!< Get how many blocks the calling thread has allocated, of any size.
+};
+
+//! \brief A standard allocator drawing from the Pool.
+template <typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator() noexcept { }
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept { }
+
+    T* allocate(std::size_t n)
+    {
+        static_assert(alignof(T) <= Pool::GRANULE, "type is too aligned for the pool");
+        return static_cast<T*>(Pool::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept { Pool::deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+//! \brief make_shared, with the object and its reference counts in one
+//! pooled block. Types with a static MEMORY_CATEGORY member are charged to
+//! it, along with whatever their constructors allocate.
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(Args&&... args)
+{
+    if constexpr (requires { T::MEMORY_CATEGORY; }) {
+        MemoryScope scope(T::MEMORY_CATEGORY);
+        return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+    } else {
+        return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+    }
+}
+
+#endif
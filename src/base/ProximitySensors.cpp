@@ -0,0 +1,224 @@
+#include "base/ProximitySensors.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+
+ProximitySensors::ProximitySensors(const Level& level)
+    : mLevel(level)
+{
+}
+
+int ProximitySensors::add(const GameObject& owner, std::weak_ptr<GameObject> target, float radius)
+{
+    std::shared_ptr<GameObject> targetShared = target.lock();
+    const GameObject* key = targetShared.get();
+    int targetId = findTarget(false, key, 0.0f, 0.0f);
+    if (targetId < 0) {
+        targetId = addTarget({ target, key, false, 0.0f, 0.0f, 0.0f, 0 });
+    }
+    return addSensor(owner, targetId, radius);
+}
+
+int ProximitySensors::add(const GameObject& owner, float x, float y, float radius)
+{
+    int targetId = findTarget(true, nullptr, x, y);
+    if (targetId < 0) {
+        targetId = addTarget({ std::weak_ptr<GameObject>(), nullptr, true, x, y, 0.0f, 0 });
+    }
+    return addSensor(owner, targetId, radius);
+}
+
+int ProximitySensors::ensure(int sensor, const GameObject& owner, const std::weak_ptr<GameObject>& target, float radius)
+{
+    std::shared_ptr<GameObject> targetShared = target.lock();
+    const GameObject* key = targetShared.get();
+    if (sensor >= 0 && sensor < int(mOwner.size()) && mOwner[sensor] == &owner && !mTargets[mTarget[sensor]].point && mTargets[mTarget[sensor]].key == key && mRadius[sensor] == radius) {
+        return sensor;
+    }
+    const int targetId = findTarget(false, key, 0.0f, 0.0f);
+    const int existing = targetId < 0 ? -1 : findSensor(owner, targetId, radius);
+    return existing >= 0 ? existing : add(owner, target, radius);
+}
+
+int ProximitySensors::ensure(int sensor, const GameObject& owner, float x, float y, float radius)
+{
+    if (sensor >= 0 && sensor < int(mOwner.size()) && mOwner[sensor] == &owner) {
+        const Target& target = mTargets[mTarget[sensor]];
+        if (target.point && target.x == x && target.y == y && mRadius[sensor] == radius) {
+            return sensor;
+        }
+    }
+    const int targetId = findTarget(true, nullptr, x, y);
+    const int existing = targetId < 0 ? -1 : findSensor(owner, targetId, radius);
+    return existing >= 0 ? existing : add(owner, x, y, radius);
+}
+
+void ProximitySensors::remove(int sensor)
+{
+    if (sensor < 0 || sensor >= int(mOwner.size()) || !mOwner[sensor]) {
+        return;
+    }
+
+    auto range = mByOwner.equal_range(mOwner[sensor]);
+    for (auto ii = range.first; ii != range.second; ++ii) {
+        if (ii->second == sensor) {
+            mByOwner.erase(ii);
+            break;
+        }
+    }
+
+    Target& target = mTargets[mTarget[sensor]];
+    if (--target.sensors == 0) {
+        target.object.reset();
+        target.key = nullptr;
+    }
+
+    mOwner[sensor] = nullptr;
+    mState[sensor] = 0;
+    mFreeSensors.push_back(sensor);
+}
+
+void ProximitySensors::removeOwner(const GameObject& owner)
+{
+    auto range = mByOwner.equal_range(&owner);
+    std::vector<int> sensors;
+    for (auto ii = range.first; ii != range.second; ++ii) {
+        sensors.push_back(ii->second);
+    }
+    for (int sensor : sensors) {
+        remove(sensor);
+    }
+}
+
+void ProximitySensors::update()
+{
+    const int count = int(mOwner.size());
+
+    // snapshot owner positions and age the results
+    mXs.resize(count);
+    mYs.resize(count);
+    float maxRadius = 0.0f;
+    for (int ii = 0; ii < count; ++ii) {
+        if (mOwner[ii]) {
+            mXs[ii] = mOwner[ii]->x();
+            mYs[ii] = mOwner[ii]->y();
+            maxRadius = std::max(maxRadius, mRadius[ii]);
+        } else {
+            mXs[ii] = mYs[ii] = NAN;
+        }
+        mState[ii] = (mState[ii] & NEAR) ? WAS_NEAR : 0;
+    }
+    if (count == 0) {
+        return;
+    }
+    mGrid.build(mXs.data(), mYs.data(), count, std::max(maxRadius, SIZE));
+
+    // for each target, only visit the owners in cells within reach
+    for (int tt = 0; tt < int(mTargets.size()); ++tt) {
+        Target& target = mTargets[tt];
+        if (target.sensors == 0) {
+            continue;
+        }
+        if (!target.point) {
+            std::shared_ptr<GameObject> object = target.object.lock();
+            if (!object || !mLevel.hasObject(object)) {
+                continue;
+            }
+            target.x = object->x();
+            target.y = object->y();
+        }
+
+        const float tx = target.x;
+        const float ty = target.y;
+        const float reach = target.maxRadius;
+        mGrid.query(tx - reach, ty - reach, tx + reach, ty + reach, [&](int sensor) {
+            if (mTarget[sensor] != tt) {
+                return;
+            }
+            const float dX = tx - mXs[sensor];
+            const float dY = ty - mYs[sensor];
+            if (dX * dX + dY * dY <= mRadius[sensor] * mRadius[sensor]) {
+                mState[sensor] |= NEAR;
+            }
+        });
+    }
+}
+
+int ProximitySensors::addSensor(const GameObject& owner, int target, float radius)
+{
+    int sensor;
+    if (!mFreeSensors.empty()) {
+        sensor = mFreeSensors.back();
+        mFreeSensors.pop_back();
+    } else {
+        sensor = int(mOwner.size());
+        mOwner.push_back(nullptr);
+        mTarget.push_back(0);
+        mRadius.push_back(0.0f);
+        mState.push_back(0);
+    }
+
+    mOwner[sensor] = &owner;
+    mTarget[sensor] = target;
+    mRadius[sensor] = radius;
+    mByOwner.insert(std::make_pair(&owner, sensor));
+
+    Target& targetRef = mTargets[target];
+    ++targetRef.sensors;
+    targetRef.maxRadius = std::max(targetRef.maxRadius, radius);
+
+    // give a valid answer right away; the next batched pass takes over
+    mState[sensor] = test(sensor) ? (NEAR | WAS_NEAR) : 0;
+    return sensor;
+}
+
+int ProximitySensors::findTarget(bool point, const GameObject* key, float x, float y) const
+{
+    for (size_t ii = 0; ii < mTargets.size(); ++ii) {
+        const Target& target = mTargets[ii];
+        if (target.sensors > 0 && target.point == point && target.key == key && (!point || (target.x == x && target.y == y))) {
+            return int(ii);
+        }
+    }
+    return -1;
+}
+
+int ProximitySensors::addTarget(const Target& target)
+{
+    for (size_t ii = 0; ii < mTargets.size(); ++ii) {
+        if (mTargets[ii].sensors == 0) {
+            mTargets[ii] = target;
+            return int(ii);
+        }
+    }
+    mTargets.push_back(target);
+    return int(mTargets.size()) - 1;
+}
+
+int ProximitySensors::findSensor(const GameObject& owner, int target, float radius) const
+{
+    auto range = mByOwner.equal_range(&owner);
+    for (auto ii = range.first; ii != range.second; ++ii) {
+        if (mTarget[ii->second] == target && mRadius[ii->second] == radius) {
+            return ii->second;
+        }
+    }
+    return -1;
+}
+
+bool ProximitySensors::test(int sensor) const
+{
+    const Target& target = mTargets[mTarget[sensor]];
+    float tx = target.x;
+    float ty = target.y;
+    if (!target.point) {
+        std::shared_ptr<GameObject> object = target.object.lock();
+        if (!object || !mLevel.hasObject(object)) {
+            return false;
+        }
+        tx = object->x();
+        ty = object->y();
+    }
+    const float dX = tx - mOwner[sensor]->x();
+    const float dY = ty - mOwner[sensor]->y();
+    return dX * dX + dY * dY <= mRadius[sensor] * mRadius[sensor];
+}
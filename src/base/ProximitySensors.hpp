@@ -0,0 +1,81 @@
+#ifndef BASE_PROXIMITY_SENSORS
+#define BASE_PROXIMITY_SENSORS
+
+#include "base/UniformGrid.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+class Level;
+
+//! \brief Answers "is this object within some distance of that target" for
+//! many sensors at once. A sensor is an (owner, target, radius) triple where
+//! the target is another object or a fixed point. The level evaluates every
+//! sensor in one batched pass per tick, using a grid over the owners, and AI
+//! code reads the cached result or the enter/exit events.
+class ProximitySensors {
+public:
+    ProximitySensors(const Level& level);
+
+    int add(const GameObject& owner, std::weak_ptr<GameObject> target, float radius); //!< Add a sensor for an object target and return its id.
+    int add(const GameObject& owner, float x, float y, float radius); //!< Add a sensor for a point target and return its id.
+
+    //! \brief Get a sensor id that is valid for the given owner and object
+    //! target: the given id if it still is, else an existing match or a new
+    //! sensor. AI nodes keep the returned id and pass it back each time.
+    int ensure(int sensor, const GameObject& owner, const std::weak_ptr<GameObject>& target, float radius);
+    int ensure(int sensor, const GameObject& owner, float x, float y, float radius); //!< Same, for a point target.
+
+    void remove(int sensor); //!< Remove a sensor; its id may be reused.
+    void removeOwner(const GameObject& owner); //!< Remove all sensors of an object leaving the level.
+
+    void update(); //!< Evaluate all sensors; called once per tick by the level.
+
+    inline bool isNear(int sensor) const { return mState[sensor] & NEAR; } //!< Get if the owner is within the radius of the target.
+    inline bool entered(int sensor) const { return mState[sensor] == NEAR; } //!< Get if the owner came within the radius this tick.
+    inline bool exited(int sensor) const { return mState[sensor] == WAS_NEAR; } //!< Get if the owner left the radius this tick.
+
+private:
+    ProximitySensors(const ProximitySensors&) = delete;
+    void operator=(ProximitySensors const&) = delete;
+
+    enum : unsigned char {
+        NEAR = 1,
+        WAS_NEAR = 2,
+    };
+
+    //! \brief Something sensors measure the distance to.
+    struct Target {
+        std::weak_ptr<GameObject> object; //!< the object, if not a point
+        const GameObject* key; //!< identity of the object, if not a point
+        bool point; //!< if the target is a fixed point
+        float x, y; //!< the point, or the object position during update
+        float maxRadius; //!< largest radius of the sensors on this target
+        int sensors; //!< number of sensors on this target, 0 if the slot is free
+    };
+
+    int addSensor(const GameObject& owner, int target, float radius);
+    int findTarget(bool point, const GameObject* key, float x, float y) const;
+    int addTarget(const Target& target);
+    int findSensor(const GameObject& owner, int target, float radius) const;
+    bool test(int sensor) const; //!< Evaluate one sensor on its own.
+
+    const Level& mLevel;
+
+    // sensors, by id; a null owner marks a free id
+    std::vector<const GameObject*> mOwner;
+    std::vector<int> mTarget;
+    std::vector<float> mRadius;
+    std::vector<unsigned char> mState;
+    std::vector<int> mFreeSensors;
+
+    std::vector<Target> mTargets;
+    std::unordered_multimap<const GameObject*, int> mByOwner; //!< sensor ids of each owner
+
+    // scratch for update, kept to avoid reallocating
+    std::vector<float> mXs, mYs;
+    UniformGrid mGrid;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef BASE_RANDOM
+#define BASE_RANDOM
+
+#include <cstdint>
+
+//! \brief A small random number generator (PCG32). Each level owns one, so
+//! levels running side by side draw independent, reproducible sequences;
+//! its whole state is two integers, so snapshots save it like any value.
+class Random {
+public:
+    explicit Random(std::uint64_t seed = 0) { this->seed(seed); }
+
+    //! \brief Restart the sequence from a seed.
+    void seed(std::uint64_t seed)
+    {
+        mState = 0;
+        mInc = (seed << 1) | 1;
+        next();
+        mState += seed;
+        next();
+    }
+
+    //! \brief Get the next number, uniform over 32 bits.
+    std::uint32_t next()
+    {
+        std::uint64_t old = mState;
+        mState = old * 6364136223846793005ULL + mInc;
+        std::uint32_t xorshifted = std::uint32_t(((old >> 18) ^ old) >> 27);
+        std::uint32_t rot = std::uint32_t(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    //! \brief Get a number from 0 to n - 1, as rand() % n would.
+    inline int next(int n) { return int(next() % std::uint32_t(n)); }
+
+private:
+    std::uint64_t mState, mInc;
+};
+
+#endif
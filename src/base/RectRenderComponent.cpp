@@ -1,5 +1,6 @@
 #include "base/RectRenderComponent.hpp"
 #include "base/GameObject.hpp"
+#include "base/Snapshot.hpp"
 
 RectRenderComponent::RectRenderComponent(GameObject & gameObject, Uint8 r, Uint8 g, Uint8 b):
   RenderComponent(gameObject),
@@ -17,3 +18,33 @@ RectRenderComponent::render(SDL_Renderer * renderer) const
   SDL_SetRenderDrawColor(renderer, mR, mG, mB, 0xFF);
   SDL_RenderFillRect(renderer, &fillRect);
 }
+
+bool
+RectRenderComponent::setColor(Uint8 r, Uint8 g, Uint8 b)
+{
+  if (r == mR && g == mG && b == mB) {
+    return false;
+  }
+  mR = r;
+  mG = g;
+  mB = b;
+  return true;
+}
+
+void
+RectRenderComponent::save(Snapshot & snapshot) const
+{
+  snapshot.write(mR);
+  snapshot.write(mG);
+  snapshot.write(mB);
+}
+
+bool
+RectRenderComponent::load(SnapshotReader & reader)
+{
+  Uint8 r, g, b;
+  reader.read(r);
+  reader.read(g);
+  reader.read(b);
+  return setColor(r, g, b);
+}
@@ -11,6 +11,9 @@ public:
   RectRenderComponent(GameObject & gameObject, Uint8 r, Uint8 g, Uint8 b);
   
   virtual void render(SDL_Renderer * renderer) const override;
+  virtual bool setColor(Uint8 r, Uint8 g, Uint8 b) override;
+  virtual void save(Snapshot & snapshot) const override;
+  virtual bool load(SnapshotReader & reader) override;
 
 private:
 
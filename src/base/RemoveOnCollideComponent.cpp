@@ -1,5 +1,6 @@
 #include "base/RemoveOnCollideComponent.hpp"
 #include "base/Level.hpp"
+#include <algorithm>
 
 RemoveOnCollideComponent::RemoveOnCollideComponent(GameObject& gameObject, int tag)
     : GenericComponent(gameObject)
@@ -13,3 +14,17 @@ void RemoveOnCollideComponent::collision(Level& level, std::shared_ptr<GameObjec
         level.removeObject(obj);
     }
 }
+
+bool RemoveOnCollideComponent::canSleep() const
+{
+    return true;
+}
+
+void RemoveOnCollideComponent::collisions(Level& level, const std::vector<std::shared_ptr<GameObject>>& objs)
+{
+    // grouped by tag, so the matches are one run
+    auto first = std::find_if(objs.begin(), objs.end(), [this](const std::shared_ptr<GameObject>& obj) { return obj->tag() == mTag; });
+    for (auto it = first; it != objs.end() && (*it)->tag() == mTag; ++it) {
+        level.removeObject(*it);
+    }
+}
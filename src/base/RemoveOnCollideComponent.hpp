@@ -9,6 +9,8 @@ public:
     RemoveOnCollideComponent(GameObject& gameObject, int tag);
 
     virtual void collision(Level& level, std::shared_ptr<GameObject> obj) override;
+    virtual void collisions(Level& level, const std::vector<std::shared_ptr<GameObject>>& objs) override;
+    virtual bool canSleep() const override;
 
 private:
     int mTag;
@@ -2,15 +2,24 @@
 #define BASE_RENDER_COMPONENT
 
 #include "base/Component.hpp"
+#include "base/Memory.hpp"
 #include <SDL.h>
 
+class Snapshot;
+class SnapshotReader;
+
 //! \brief A component that handles rendering.
 class RenderComponent: public Component {
 public:
+
+  static constexpr Memory::Category MEMORY_CATEGORY = Memory::RENDER; //!< what makePooled charges render components to
   
   RenderComponent(GameObject & gameObject);
 
   virtual void render(SDL_Renderer * renderer) const = 0; //!< Do the render.
+  virtual bool setColor(Uint8 r, Uint8 g, Uint8 b) { (void)r; (void)g; (void)b; return false; } //!< Change the color the object is drawn in, and get if it changed.
+  virtual void save(Snapshot & snapshot) const { (void)snapshot; } //!< Write what can change after construction to a snapshot.
+  virtual bool load(SnapshotReader & reader) { (void)reader; return false; } //!< Read back what save wrote, and get if the object looks different for it.
 
 };
 
@@ -9,11 +9,12 @@
 #include <time.h>
 
 // Initialization function
-SDLGraphicsProgram::SDLGraphicsProgram(std::shared_ptr<Level> level)
+SDLGraphicsProgram::SDLGraphicsProgram(std::shared_ptr<Level> level, bool headless)
     : mLevel(level)
 {
     // Initialize random number generation.
-    srand(time(nullptr));
+    mSeed = unsigned(time(nullptr));
+    mLevel->random().seed(mSeed);
 
     // Initialization flag
     bool success = true;
@@ -23,7 +24,25 @@ SDLGraphicsProgram::SDLGraphicsProgram(std::shared_ptr<Level> level)
     mWindow = nullptr;
 
     // Initialize SDL
-    if (SDL_Init(SDL_INIT_EVERYTHING) < 0) {
+    if (headless) {
+        if (SDL_Init(SDL_INIT_TIMER) < 0) {
+            errorStream << "SDL could not initialize! SDL Error: " << SDL_GetError() << "\n";
+            success = false;
+        }
+
+        // Create a surface in memory and a software renderer that draws to it
+        mSurface = SDL_CreateRGBSurfaceWithFormat(0, mLevel->w(), mLevel->h(), 32, SDL_PIXELFORMAT_RGB888);
+        if (mSurface == nullptr) {
+            errorStream << "Surface could not be created! SDL Error: " << SDL_GetError() << "\n";
+            success = false;
+        } else {
+            mRenderer = SDL_CreateSoftwareRenderer(mSurface);
+            if (mRenderer == nullptr) {
+                errorStream << "Renderer could not be created! SDL Error: " << SDL_GetError() << "\n";
+                success = false;
+            }
+        }
+    } else if (SDL_Init(SDL_INIT_EVERYTHING) < 0) {
         errorStream << "SDL could not initialize! SDL Error: " << SDL_GetError() << "\n";
         success = false;
     } else {
@@ -45,7 +64,7 @@ SDLGraphicsProgram::SDLGraphicsProgram(std::shared_ptr<Level> level)
         }
     }
 
-    InputManager::getInstance().startUp();
+    mLevel->input().startUp();
 
     // If initialization did not work, then print out a list of errors in the constructor.
     if (!success) {
@@ -60,7 +79,7 @@ SDLGraphicsProgram::SDLGraphicsProgram(std::shared_ptr<Level> level)
 // Proper shutdown and destroy initialized objects
 SDLGraphicsProgram::~SDLGraphicsProgram()
 {
-    InputManager::getInstance().shutDown();
+    mLevel->input().shutDown();
 
     // Destroy Renderer
     SDL_DestroyRenderer(mRenderer);
@@ -70,6 +89,10 @@ SDLGraphicsProgram::~SDLGraphicsProgram()
     SDL_DestroyWindow(mWindow);
     mWindow = nullptr;
 
+    // Destroy surface
+    SDL_FreeSurface(mSurface);
+    mSurface = nullptr;
+
     // Quit SDL subsystems
     SDL_Quit();
 }
@@ -84,6 +107,12 @@ void SDLGraphicsProgram::update()
 // The render function gets called once per loop
 void SDLGraphicsProgram::render()
 {
+    // the surface keeps the last frame, so just patch what changed
+    if (mSurface) {
+        mLevel->renderDirty(mRenderer, 0x22, 0x22, 0x22);
+        return;
+    }
+
     SDL_SetRenderDrawColor(mRenderer, 0x22, 0x22, 0x22, 0xFF);
     SDL_RenderClear(mRenderer);
 
@@ -102,25 +131,79 @@ void SDLGraphicsProgram::loop()
     // that are related to input and output
     SDL_Event e;
 
+    SimClock& clock = mLevel->clock();
+    Uint32 last = SDL_GetTicks();
+    Uint64 lastCounter = SDL_GetPerformanceCounter();
+
     // While application is running
     while (!quit) {
-        InputManager::getInstance().resetForFrame();
+        Uint32 now = SDL_GetTicks();
+        const Uint64 counter = SDL_GetPerformanceCounter();
 
-        // Handle events on queue
+        // Handle events on queue; key events already reached the input
+        // manager's queue through its event watch when they arrived
         while (SDL_PollEvent(&e) != 0) {
             if (e.type == SDL_QUIT) {
                 quit = true;
             }
-            InputManager::getInstance().handleEvent(e);
         }
 
-        // update
-        update();
+        // run as many ticks as the wall time since the last frame calls for
+        // at the clock's scale; as fast as possible, run ticks until this
+        // frame's time is used up. Each tick takes the events that arrived
+        // by the end of its share of that wall time, or by when it runs
+        const bool fastest = clock.scale() == SimClock::FASTEST;
+        const unsigned due = fastest ? 0 : clock.due(now - last);
+        for (unsigned ii = 0; fastest ? ii == 0 || SDL_GetTicks() - now < 33 : ii < due; ++ii) {
+            const Uint64 until = fastest ? SDL_GetPerformanceCounter() : lastCounter + (counter - lastCounter) * (ii + 1) / due;
+            mLevel->input().consumeEvents(until);
+            tick();
+        }
+        last = now;
+        lastCounter = counter;
 
         // render
         render();
 
-        // Reduce framerate
-        SDL_Delay(33);
+        // Reduce framerate; keep pumping events meanwhile, so they are
+        // stamped within a millisecond of arriving rather than at the next frame
+        while (!fastest && SDL_GetTicks() - now < 33) {
+            SDL_PumpEvents();
+            SDL_Delay(1);
+        }
+    }
+}
+
+void SDLGraphicsProgram::tick()
+{
+    if (mRecording) {
+        mRecording->capture(mLevel->time(), mLevel->input());
+    }
+
+    update();
+
+    // a key press counts in one tick only
+    mLevel->input().resetForFrame();
+}
+
+void SDLGraphicsProgram::record(InputRecording* recording)
+{
+    mRecording = recording;
+    if (mRecording) {
+        mRecording->setSeed(mSeed);
+    }
+}
+
+void SDLGraphicsProgram::replay(const InputRecording& recording)
+{
+    mSeed = recording.seed();
+    mLevel->random().seed(mSeed);
+
+    for (size_t ii = 0; ii < recording.frameCount(); ++ii) {
+        recording.apply(ii, mLevel->input());
+        mLevel->clock().set(recording.frame(ii).time, ii);
+
+        update();
+        render();
     }
 }
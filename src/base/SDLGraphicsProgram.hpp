@@ -5,6 +5,7 @@
 #ifndef BASE_SDL_GRAPHICS_PROGRAM_HPP
 #define BASE_SDL_GRAPHICS_PROGRAM_HPP
 
+#include "base/InputRecording.hpp"
 #include "base/Level.hpp"
 #include <memory.h>
 #include <SDL.h>
@@ -13,8 +14,8 @@
 class SDLGraphicsProgram {
 public:
 
-  // Constructor
-  SDLGraphicsProgram(std::shared_ptr<Level> level);
+  // Constructor; a headless program renders in software to an in-memory surface
+  SDLGraphicsProgram(std::shared_ptr<Level> level, bool headless = false);
 
   // Desctructor
   ~SDLGraphicsProgram();
@@ -25,13 +26,33 @@ public:
   // Renders shapes to the screen
   void render();
 
-  // loop that runs forever
+  // loop that runs forever, ticking the level as its clock's scale says
   void loop();
 
+  // Record each tick's input into recording while looping (nullptr to stop)
+  void record(InputRecording * recording);
+
+  // Play a recording back as fast as possible, from its seed; the level
+  // must start as it did when the recording was made
+  void replay(const InputRecording & recording);
+
+  // The seed the random number generator was started with
+  unsigned seed() const { return mSeed; }
+
+  // The surface a headless program renders to, or nullptr
+  SDL_Surface * surface() const { return mSurface; }
+
 private:
 
+  // Run one tick of the level, recording its input if asked to
+  void tick();
+
   // the current level
   std::shared_ptr<Level> mLevel;
+
+  // random seed, and where to record input to, if anywhere
+  unsigned mSeed;
+  InputRecording * mRecording = nullptr;
   
   // The window we'll be rendering to
   SDL_Window * mWindow = nullptr;
@@ -39,6 +60,10 @@ private:
   // SDL Renderer
   SDL_Renderer * mRenderer = nullptr;
 
+  // Memory surface for headless rendering; its contents persist between
+  // frames, so only the regions that changed are redrawn
+  SDL_Surface * mSurface = nullptr;
+
 };
 
 #endif
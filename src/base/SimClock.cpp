@@ -0,0 +1,41 @@
+#include "base/SimClock.hpp"
+#include <algorithm>
+
+// the most wall time one call to due makes up for, so a stall (a debugger,
+// a dragged window) is not followed by a burst of ticks
+static const Uint32 MAX_ELAPSED = 250;
+
+SimClock::SimClock(Uint32 step)
+    : mNow(0)
+    , mTicks(0)
+    , mStep(step)
+    , mScale(1.0f)
+    , mOwed(0.0f)
+{
+}
+
+void SimClock::advance()
+{
+    mNow += mStep;
+    ++mTicks;
+}
+
+void SimClock::set(Uint32 now, std::uint64_t ticks)
+{
+    mNow = now;
+    mTicks = ticks;
+}
+
+void SimClock::setScale(float scale)
+{
+    mScale = std::max(scale, 0.0f);
+    mOwed = 0.0f;
+}
+
+unsigned SimClock::due(Uint32 elapsed)
+{
+    mOwed += std::min(elapsed, MAX_ELAPSED) * mScale;
+    unsigned ticks = unsigned(mOwed / mStep);
+    mOwed -= float(ticks) * mStep;
+    return ticks;
+}
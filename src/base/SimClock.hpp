@@ -0,0 +1,47 @@
+#ifndef BASE_SIM_CLOCK
+#define BASE_SIM_CLOCK
+
+#include <SDL.h>
+#include <cstdint>
+#include <limits>
+
+//! \brief The simulated time of a level. It moves on by a fixed step each
+//! tick, whatever the wall clock does, so anything timed against it (AI
+//! waits, timers, transitions) behaves the same whether the level runs in
+//! real time, fast forward, or as fast as the machine allows.
+//!
+//! The scale only decides how many ticks the program runs per frame of wall
+//! time: 0 pauses, 1 is real time, 100 is a hundred times faster, and
+//! FASTEST runs ticks back to back. It never changes what a tick does.
+class SimClock {
+public:
+    static constexpr float FASTEST = std::numeric_limits<float>::infinity();
+
+    SimClock(Uint32 step = 33);
+
+    inline Uint32 now() const { return mNow; } //!< Get the time of the current tick, in milliseconds.
+    inline std::uint64_t ticks() const { return mTicks; } //!< Get the number of ticks run.
+    inline Uint32 step() const { return mStep; } //!< Get the milliseconds of simulated time per tick.
+    inline void setStep(Uint32 step) { mStep = step; }
+
+    void advance(); //!< Move on to the next tick; the level does this at the end of each update.
+    void set(Uint32 now, std::uint64_t ticks); //!< Jump to a time, when restoring or replaying.
+
+    inline float scale() const { return mScale; } //!< Get how many times faster than real time to run.
+    void setScale(float scale);
+
+    //! \brief Get how many ticks to run for the given wall time passed since
+    //! the last call, at the current scale. Fractions of a tick carry over,
+    //! and long stalls are not made up in full. Not meant for FASTEST.
+    unsigned due(Uint32 elapsed);
+
+private:
+    Uint32 mNow;
+    std::uint64_t mTicks;
+    Uint32 mStep;
+
+    float mScale;
+    float mOwed; //!< simulated milliseconds due but not yet run
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "base/Snapshot.hpp"
+#include "base/GameObject.hpp"
+#include <algorithm>
+
+void Snapshot::clear()
+{
+    mData.clear();
+    mShared.clear();
+    mObjects.clear();
+    mObjectsToAdd.clear();
+    mObjectsToRemove.clear();
+}
+
+SnapshotReader::SnapshotReader(const Snapshot& snapshot)
+    : mSnapshot(snapshot)
+    , mPos(0)
+{
+}
+
+static void appendRun(std::vector<unsigned char>& runs, const unsigned char* data, std::uint32_t offset, std::uint32_t length)
+{
+    const unsigned char* header[2] = { reinterpret_cast<const unsigned char*>(&offset), reinterpret_cast<const unsigned char*>(&length) };
+    runs.insert(runs.end(), header[0], header[0] + sizeof(offset));
+    runs.insert(runs.end(), header[1], header[1] + sizeof(length));
+    runs.insert(runs.end(), data + offset, data + offset + length);
+}
+
+void SnapshotDelta::encode(const Snapshot& from, const Snapshot& to)
+{
+    // compare a word at a time; changes closer than a run header apart are
+    // sent as one run
+    const std::size_t WORD = 8;
+    const std::size_t GAP = 2 * sizeof(std::uint32_t);
+
+    mRuns.clear();
+    mSize = std::uint32_t(to.mData.size());
+    const std::size_t common = std::min(from.mData.size(), to.mData.size());
+    const unsigned char* a = from.mData.data();
+    const unsigned char* b = to.mData.data();
+
+    std::size_t runStart = 0;
+    std::size_t runEnd = 0;
+    bool inRun = false;
+    for (std::size_t at = 0; at < common; at += WORD) {
+        std::size_t n = std::min(WORD, common - at);
+        if (std::memcmp(a + at, b + at, n) == 0) {
+            continue;
+        }
+        if (inRun && at - runEnd > GAP) {
+            appendRun(mRuns, b, std::uint32_t(runStart), std::uint32_t(runEnd - runStart));
+            inRun = false;
+        }
+        if (!inRun) {
+            runStart = at;
+            inRun = true;
+        }
+        runEnd = at + n;
+    }
+    if (to.mData.size() > common) {
+        if (!inRun) {
+            runStart = common;
+            inRun = true;
+        }
+        runEnd = to.mData.size();
+    }
+    if (inRun) {
+        appendRun(mRuns, b, std::uint32_t(runStart), std::uint32_t(runEnd - runStart));
+    }
+
+    mShared.clear();
+    mSharedCount = std::uint32_t(to.mShared.size());
+    for (std::uint32_t i = 0; i < mSharedCount; ++i) {
+        if (i >= from.mShared.size() || from.mShared[i] != to.mShared[i]) {
+            mShared.emplace_back(i, to.mShared[i]);
+        }
+    }
+
+    mObjectsChanged = from.mObjects != to.mObjects || from.mObjectsToAdd != to.mObjectsToAdd || from.mObjectsToRemove != to.mObjectsToRemove;
+    if (mObjectsChanged) {
+        mObjects = to.mObjects;
+        mObjectsToAdd = to.mObjectsToAdd;
+        mObjectsToRemove = to.mObjectsToRemove;
+    } else {
+        mObjects.clear();
+        mObjectsToAdd.clear();
+        mObjectsToRemove.clear();
+    }
+}
+
+void SnapshotDelta::apply(const Snapshot& from, Snapshot& to) const
+{
+    to.mData.assign(from.mData.begin(), from.mData.begin() + std::min<std::size_t>(from.mData.size(), mSize));
+    to.mData.resize(mSize);
+    for (std::size_t at = 0; at < mRuns.size();) {
+        std::uint32_t offset, length;
+        std::memcpy(&offset, mRuns.data() + at, sizeof(offset));
+        std::memcpy(&length, mRuns.data() + at + sizeof(offset), sizeof(length));
+        at += sizeof(offset) + sizeof(length);
+        std::memcpy(to.mData.data() + offset, mRuns.data() + at, length);
+        at += length;
+    }
+
+    to.mShared.assign(from.mShared.begin(), from.mShared.begin() + std::min<std::size_t>(from.mShared.size(), mSharedCount));
+    to.mShared.resize(mSharedCount);
+    for (const auto& change : mShared) {
+        to.mShared[change.first] = change.second;
+    }
+
+    to.mObjects = mObjectsChanged ? mObjects : from.mObjects;
+    to.mObjectsToAdd = mObjectsChanged ? mObjectsToAdd : from.mObjectsToAdd;
+    to.mObjectsToRemove = mObjectsChanged ? mObjectsToRemove : from.mObjectsToRemove;
+}
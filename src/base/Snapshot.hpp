@@ -0,0 +1,117 @@
+#ifndef BASE_SNAPSHOT
+#define BASE_SNAPSHOT
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+class GameObject;
+
+//! \brief The simulation state of a level at one moment, for rollback and
+//! what-if branches. Level::save fills it and Level::restore puts the level
+//! back the way it was. Plain values (positions, velocities, node statuses,
+//! timers...) go into one contiguous byte buffer; references to shared
+//! objects a restore must put back (render components, the objects in the
+//! level) are kept alongside. Saving again into the same snapshot reuses its
+//! memory, so taking one every tick allocates nothing once warmed up.
+//!
+//! Components, nodes, states and transitions add their own state by
+//! overriding save and load, which must read back exactly what they wrote.
+class Snapshot {
+public:
+    void clear(); //!< Forget everything, keeping the memory.
+
+    template <typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+        std::size_t at = mData.size();
+        mData.resize(at + sizeof(T));
+        std::memcpy(mData.data() + at, &value, sizeof(T));
+    }
+
+    //! \brief Keep a reference to a shared object, to be handed back by readShared.
+    template <typename T>
+    void writeShared(const std::shared_ptr<T>& ptr)
+    {
+        write(std::uint32_t(mShared.size()));
+        mShared.push_back(ptr);
+    }
+
+    inline std::size_t size() const { return mData.size(); } //!< Get the size of the byte buffer.
+
+private:
+    friend class Level;
+    friend class SnapshotReader;
+    friend class SnapshotDelta;
+
+    std::vector<unsigned char> mData;
+    std::vector<std::shared_ptr<void>> mShared;
+
+    // the level's objects, and those waiting to be added or removed
+    std::vector<std::shared_ptr<GameObject>> mObjects;
+    std::vector<std::shared_ptr<GameObject>> mObjectsToAdd;
+    std::vector<std::shared_ptr<GameObject>> mObjectsToRemove;
+};
+
+//! \brief Reads back what was written to a snapshot, in the same order.
+class SnapshotReader {
+public:
+    SnapshotReader(const Snapshot& snapshot);
+
+    template <typename T>
+    void read(T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read");
+        assert(mPos + sizeof(T) <= mSnapshot.mData.size() && "read past the end of the snapshot");
+        std::memcpy(&value, mSnapshot.mData.data() + mPos, sizeof(T));
+        mPos += sizeof(T);
+    }
+
+    template <typename T>
+    std::shared_ptr<T> readShared()
+    {
+        std::uint32_t index;
+        read(index);
+        assert(index < mSnapshot.mShared.size() && "no such shared reference in the snapshot");
+        return std::static_pointer_cast<T>(mSnapshot.mShared[index]);
+    }
+
+    inline std::size_t position() const { return mPos; }
+    inline bool atEnd() const { return mPos == mSnapshot.mData.size(); } //!< Get if everything written has been read.
+    inline void seek(std::size_t pos) { mPos = pos; }
+
+private:
+    const Snapshot& mSnapshot;
+    std::size_t mPos;
+};
+
+//! \brief The difference between two snapshots of the same level, as the
+//! runs of bytes that changed plus whatever references changed. Consecutive
+//! snapshots mostly differ in the few objects that moved, so a history of
+//! one full snapshot and deltas is much smaller than full snapshots.
+class SnapshotDelta {
+public:
+    void encode(const Snapshot& from, const Snapshot& to); //!< Record how to get from one snapshot to another.
+    void apply(const Snapshot& from, Snapshot& to) const; //!< Rebuild the later snapshot from the one encode was given first.
+
+    inline std::size_t size() const { return mRuns.size(); } //!< Get the size of the encoded byte runs.
+
+private:
+    std::vector<unsigned char> mRuns; //!< (offset, length, bytes) runs changed in the byte buffer
+    std::uint32_t mSize; //!< size of the later byte buffer
+
+    std::vector<std::pair<std::uint32_t, std::shared_ptr<void>>> mShared; //!< changed shared references by index
+    std::uint32_t mSharedCount;
+
+    bool mObjectsChanged; //!< if the membership lists differ, in which case they are copied whole
+    std::vector<std::shared_ptr<GameObject>> mObjects;
+    std::vector<std::shared_ptr<GameObject>> mObjectsToAdd;
+    std::vector<std::shared_ptr<GameObject>> mObjectsToRemove;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "base/SpatialIndex.hpp"
+#include "base/GameObject.hpp"
+#include "base/Level.hpp"
+#include <algorithm>
+
+// boxes with a half size over this are checked one by one by overlapping,
+// so one wall does not widen every search for the small objects
+static const float LARGE_HALF_SIZE = SIZE * 2.0f;
+
+SpatialIndex::SpatialIndex()
+    : mGeneration(1)
+{
+}
+
+void SpatialIndex::invalidate()
+{
+    ++mGeneration;
+}
+
+const SpatialIndex::TagGrid& SpatialIndex::gridFor(const Level& level, int tag)
+{
+    TagGrid* found = nullptr;
+    for (TagGrid& grid : mGrids) {
+        if (grid.tag == tag) {
+            found = &grid;
+            break;
+        }
+    }
+    if (!found) {
+        mGrids.emplace_back();
+        found = &mGrids.back();
+        found->tag = tag;
+        found->built = 0;
+    }
+    TagGrid& grid = *found;
+    if (grid.built == mGeneration) {
+        return grid;
+    }
+
+    grid.indices.clear();
+    if (tag == ANY_TAG) {
+        for (std::uint32_t i = 0; i < level.objectCount(); ++i) {
+            grid.indices.push_back(i);
+        }
+    } else {
+        const std::vector<std::uint32_t>& tagged = level.objectsWithTag(tag);
+        grid.indices.assign(tagged.begin(), tagged.end());
+    }
+    grid.xs.resize(grid.indices.size());
+    grid.ys.resize(grid.indices.size());
+    grid.halfWs.resize(grid.indices.size());
+    grid.halfHs.resize(grid.indices.size());
+    grid.large.clear();
+    grid.reach = 0.0f;
+    for (std::size_t i = 0; i < grid.indices.size(); ++i) {
+        const GameObject& obj = *level.object(grid.indices[i]);
+        grid.halfWs[i] = obj.w() * 0.5f;
+        grid.halfHs[i] = obj.h() * 0.5f;
+        grid.xs[i] = obj.x() + grid.halfWs[i];
+        grid.ys[i] = obj.y() + grid.halfHs[i];
+        const float half = std::max(grid.halfWs[i], grid.halfHs[i]);
+        if (half > LARGE_HALF_SIZE) {
+            grid.large.push_back(int(i));
+        } else {
+            grid.reach = std::max(grid.reach, half);
+        }
+    }
+    grid.grid.build(grid.xs.data(), grid.ys.data(), int(grid.indices.size()), SIZE * 2.0f);
+    grid.built = mGeneration;
+    return grid;
+}
+
+std::size_t SpatialIndex::withinRadius(const Level& level, float x, float y, float radius, int tag, Hit* out, std::size_t capacity, const GameObject* exclude)
+{
+    if (!(radius >= 0.0f)) {
+        return 0;
+    }
+    const TagGrid& grid = gridFor(level, tag);
+    const float radius2 = radius * radius;
+    std::size_t count = 0;
+    grid.grid.query(x - radius, y - radius, x + radius, y + radius, [&](int point) {
+        const float dx = grid.xs[point] - x;
+        const float dy = grid.ys[point] - y;
+        const float distance2 = dx * dx + dy * dy;
+        if (distance2 > radius2 || level.object(grid.indices[point]).get() == exclude) {
+            return;
+        }
+        if (count < capacity) {
+            out[count] = { grid.indices[point], distance2 };
+        }
+        ++count;
+    });
+    return count;
+}
+
+std::size_t SpatialIndex::nearest(const Level& level, float x, float y, int tag, Hit* out, std::size_t k, const GameObject* exclude)
+{
+    if (k == 0) {
+        return 0;
+    }
+    const TagGrid& grid = gridFor(level, tag);
+    auto closer = [](const Hit& a, const Hit& b) {
+        return a.distance2 != b.distance2 ? a.distance2 < b.distance2 : a.index < b.index;
+    };
+
+    // search a square that doubles until it holds k objects within its
+    // inscribed circle, which are then the nearest, or covers the grid
+    std::size_t found = 0;
+    float reach = grid.grid.cellSize();
+    while (true) {
+        const bool all = grid.grid.covers(x - reach, y - reach, x + reach, y + reach);
+        const float reach2 = reach * reach;
+        found = 0;
+        grid.grid.query(x - reach, y - reach, x + reach, y + reach, [&](int point) {
+            const float dx = grid.xs[point] - x;
+            const float dy = grid.ys[point] - y;
+            const Hit hit = { grid.indices[point], dx * dx + dy * dy };
+            if ((!all && hit.distance2 > reach2) || level.object(hit.index).get() == exclude) {
+                return;
+            }
+            if (found == k && !closer(hit, out[k - 1])) {
+                return;
+            }
+            std::size_t at = found < k ? found++ : k - 1;
+            for (; at > 0 && closer(hit, out[at - 1]); --at) {
+                out[at] = out[at - 1];
+            }
+            out[at] = hit;
+        });
+        if (found == k || all) {
+            return found;
+        }
+        reach *= 2.0f;
+    }
+}
+
+std::size_t SpatialIndex::overlapping(const Level& level, float x0, float y0, float x1, float y1, int tag, std::uint32_t* out, std::size_t capacity)
+{
+    const TagGrid& grid = gridFor(level, tag);
+    std::size_t count = 0;
+    auto test = [&](int point) {
+        if (grid.xs[point] + grid.halfWs[point] < x0 || grid.xs[point] - grid.halfWs[point] > x1
+            || grid.ys[point] + grid.halfHs[point] < y0 || grid.ys[point] - grid.halfHs[point] > y1) {
+            return;
+        }
+        if (count < capacity) {
+            out[count] = grid.indices[point];
+        }
+        ++count;
+    };
+    // a small box overlapping the rectangle has its center within reach of it
+    grid.grid.query(x0 - grid.reach, y0 - grid.reach, x1 + grid.reach, y1 + grid.reach, [&](int point) {
+        if (std::max(grid.halfWs[point], grid.halfHs[point]) <= LARGE_HALF_SIZE) {
+            test(point);
+        }
+    });
+    for (int point : grid.large) {
+        test(point);
+    }
+    return count;
+}
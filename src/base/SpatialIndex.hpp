@@ -0,0 +1,75 @@
+#ifndef BASE_SPATIAL_INDEX
+#define BASE_SPATIAL_INDEX
+
+#include "base/UniformGrid.hpp"
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class GameObject;
+class Level;
+
+//! \brief Radius and nearest-neighbor queries over a level's objects, by
+//! the centers of their boxes, optionally only among those with one tag.
+//!
+//! Each tag queried gets a UniformGrid of its objects, built from the
+//! level's tag index the first time it is queried after the objects moved
+//! or changed, so a query for enemies costs in proportion to the enemies
+//! near the point rather than to the level. Results go into buffers the
+//! caller provides; once the grids have grown to fit, queries allocate
+//! nothing. The level reindexes after adding objects, after its physics
+//! step and after removals, so queries made while objects update see where
+//! they were at the start of the tick.
+class SpatialIndex {
+public:
+    static const int ANY_TAG = INT_MIN; //!< a tag filter matching every object
+
+    //! \brief An object a query found.
+    struct Hit {
+        std::uint32_t index; //!< the object's index in the level
+        float distance2; //!< squared distance between the query point and the object's center
+    };
+
+    SpatialIndex();
+
+    void invalidate(); //!< Have the next query index the objects where they are then.
+
+    //! \brief Find the objects with a tag whose centers are within a radius
+    //! of a point, other than exclude. Writes at most capacity of them to
+    //! out, in no particular order, and returns how many there are.
+    std::size_t withinRadius(const Level& level, float x, float y, float radius, int tag, Hit* out, std::size_t capacity, const GameObject* exclude);
+
+    //! \brief Find the k objects with a tag whose centers are nearest a
+    //! point, other than exclude. Writes them to out, nearest first and
+    //! ties in level order, and returns how many there are, at most k.
+    std::size_t nearest(const Level& level, float x, float y, int tag, Hit* out, std::size_t k, const GameObject* exclude);
+
+    //! \brief Find the objects with a tag whose boxes overlap or touch a
+    //! rectangle. Writes at most capacity of their level indices to out, in
+    //! no particular order, and returns how many there are.
+    std::size_t overlapping(const Level& level, float x0, float y0, float x1, float y1, int tag, std::uint32_t* out, std::size_t capacity);
+
+private:
+    SpatialIndex(const SpatialIndex&) = delete;
+    void operator=(SpatialIndex const&) = delete;
+
+    //! \brief The grid over the objects with one tag.
+    struct TagGrid {
+        int tag;
+        std::uint64_t built; //!< the generation it was built in
+        UniformGrid grid;
+        std::vector<float> xs, ys; //!< centers
+        std::vector<float> halfWs, halfHs; //!< half sizes, for finding boxes
+        std::vector<std::uint32_t> indices; //!< the level index of each point
+        std::vector<int> large; //!< points whose boxes are too big to find by their centers
+        float reach; //!< largest half size of the other points' boxes
+    };
+
+    const TagGrid& gridFor(const Level& level, int tag);
+
+    std::vector<TagGrid> mGrids; //!< few, so searched in order
+    std::uint64_t mGeneration; //!< bumped by invalidate
+};
+
+#endif
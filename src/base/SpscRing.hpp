@@ -0,0 +1,66 @@
+#ifndef BASE_SPSC_RING
+#define BASE_SPSC_RING
+
+#include <atomic>
+#include <cstddef>
+
+//! \brief A fixed-size, lock-free queue for one producer thread and one
+//! consumer thread. Capacity must be a power of two. push and pop never
+//! block or allocate; push fails when the ring is full.
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    SpscRing()
+        : mHead(0)
+        , mTail(0)
+    {
+    }
+
+    //! \brief Add an item; only call from the producer. Returns false if full.
+    bool push(const T& item)
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        mItems[tail & (Capacity - 1)] = item;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Take the oldest item; only call from the consumer. Returns false if empty.
+    bool pop(T& item)
+    {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = mItems[head & (Capacity - 1)];
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Look at the oldest item without taking it; only call from the consumer.
+    const T* peek() const
+    {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &mItems[head & (Capacity - 1)];
+    }
+
+private:
+    SpscRing(const SpscRing&) = delete;
+    void operator=(SpscRing const&) = delete;
+
+    // head and tail on their own cache lines, so the two threads do not
+    // invalidate each other's line on every push and pop
+    alignas(64) std::atomic<std::size_t> mHead; //!< next item to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> mTail; //!< next slot to push, written by the producer
+    alignas(64) T mItems[Capacity];
+};
+
+#endif
@@ -1,62 +1,228 @@
 #include "base/StateComponent.hpp"
 #include "base/GameObject.hpp"
+#include "base/Snapshot.hpp"
 
 StateComponent::StateComponent(GameObject& gameObject)
-    : GenericComponent(gameObject)
+    : AIComponent(gameObject)
+    , mCurrentState(-1)
+    , mOwnTable(false)
+    , mTableStale(false)
 {
 }
 
 void StateComponent::setStartState(std::shared_ptr<State> state)
 {
     mStartState = state;
+    mTableStale = mOwnTable;
 }
 
 void StateComponent::addTransition(std::shared_ptr<State> stateFrom, std::shared_ptr<State> stateTo, std::shared_ptr<Transition> transition)
 {
+    MemoryScope scope(Memory::AI);
     mTransitionMap.insert(std::make_pair(stateFrom, std::make_pair(stateTo, transition)));
+    mTableStale = mOwnTable;
 }
 
-void StateComponent::update(Level& level)
+std::shared_ptr<const StateComponent::TransitionTable> StateComponent::compile() const
 {
-    // go to start state initially
-    if (!mCurrentState) {
+    MemoryScope scope(Memory::AI);
+    std::shared_ptr<TransitionTable> table = std::make_shared<TransitionTable>();
+
+    // number the states: the start state first, then in map order
+    auto addState = [&table](const std::shared_ptr<State>& state) {
+        if (table->stateId(state.get()) < 0) {
+            table->mStates.push_back(state);
+        }
+    };
+    if (mStartState) {
+        addState(mStartState);
+    }
+    for (auto& entry : mTransitionMap) {
+        addState(entry.first);
+        addState(entry.second.first);
+    }
+
+    // lay each state's transitions out contiguously
+    table->mFirstEdge.reserve(table->mStates.size() + 1);
+    table->mEdges.reserve(mTransitionMap.size());
+    table->mTransitions.reserve(mTransitionMap.size());
+    for (auto& state : table->mStates) {
+        table->mFirstEdge.push_back(int(table->mEdges.size()));
+        auto range = mTransitionMap.equal_range(state);
+        for (auto ii = range.first; ii != range.second; ++ii) {
+            table->mEdges.push_back({ ii->second.second.get(), table->stateId(ii->second.first.get()) });
+            table->mTransitions.push_back(ii->second.second);
+        }
+    }
+    table->mFirstEdge.push_back(int(table->mEdges.size()));
+
+    return table;
+}
+
+void StateComponent::setTransitionTable(std::shared_ptr<const TransitionTable> table)
+{
+    mTable = table;
+    mOwnTable = false;
+    mTableStale = false;
+    mCurrentState = -1;
+    makeData(nullptr);
+}
+
+void StateComponent::think(Level& level)
+{
+    if (!mTable || mTableStale) {
         if (!mStartState) {
             return;
         }
 
-        makeStateCurrent(mStartState);
+        // keep the current state across a recompile caused by reconfiguring
+        std::shared_ptr<const TransitionTable> previous = mTable;
+        std::shared_ptr<State> current = (mTable && mCurrentState >= 0) ? mTable->state(mCurrentState) : nullptr;
+        mTable = compile();
+        mOwnTable = true;
+        mTableStale = false;
+        mCurrentState = current ? mTable->stateId(current.get()) : -1;
+        makeData(previous.get());
+    }
+
+    // go to start state initially
+    if (mCurrentState < 0) {
+        if (mTable->stateCount() == 0) {
+            return;
+        }
+
+        makeStateCurrent(0);
     }
 
+    const TransitionTable& table = *mTable;
+
     // update current state
-    mCurrentState->update(getGameObject(), level);
+    table.mStates[mCurrentState]->update(getGameObject(), level, mStateData[mCurrentState].get());
 
     // check transitions
-    auto range = mTransitionMap.equal_range(mCurrentState); //!< return 2 iterators(a pair), so that we know the begin and end
-    for (auto ii = range.first; ii != range.second; ++ii) {
-        if (ii->second.second->shouldTrigger(getGameObject(), level)) {
-            makeStateCurrent(ii->second.first);
+    const int end = table.mFirstEdge[mCurrentState + 1];
+    for (int ii = table.mFirstEdge[mCurrentState]; ii != end; ++ii) {
+        if (table.mEdges[ii].transition->shouldTrigger(getGameObject(), level, mTransitionData[ii].get())) {
+            makeStateCurrent(table.mEdges[ii].to);
             break;
         }
     }
 }
 
-void StateComponent::makeStateCurrent(std::shared_ptr<State> state)
+void StateComponent::save(Snapshot& snapshot) const
+{
+    snapshot.write(mCurrentState);
+    snapshot.write(mOwnTable);
+    snapshot.write(mTableStale);
+    snapshot.writeShared(std::const_pointer_cast<TransitionTable>(mTable));
+    for (auto& data : mStateData) {
+        if (data) {
+            data->save(snapshot);
+        }
+    }
+    for (auto& data : mTransitionData) {
+        if (data) {
+            data->save(snapshot);
+        }
+    }
+}
+
+void StateComponent::load(SnapshotReader& reader)
+{
+    reader.read(mCurrentState);
+    reader.read(mOwnTable);
+    reader.read(mTableStale);
+    std::shared_ptr<const TransitionTable> table = reader.readShared<const TransitionTable>();
+    if (table != mTable) {
+        mTable = table;
+        makeData(nullptr);
+    }
+    for (auto& data : mStateData) {
+        if (data) {
+            data->load(reader);
+        }
+    }
+    for (auto& data : mTransitionData) {
+        if (data) {
+            data->load(reader);
+        }
+    }
+}
+
+void StateComponent::makeData(const TransitionTable* previous)
+{
+    MemoryScope scope(Memory::AI);
+    std::vector<std::shared_ptr<Data>> stateData;
+    std::vector<std::shared_ptr<Data>> transitionData;
+    if (mTable) {
+        const TransitionTable& table = *mTable;
+        stateData.reserve(table.mStates.size());
+        for (auto& state : table.mStates) {
+            const int old = previous ? previous->stateId(state.get()) : -1;
+            stateData.push_back(old >= 0 ? std::move(mStateData[old]) : state->makeData());
+        }
+        transitionData.reserve(table.mEdges.size());
+        for (const TransitionTable::Edge& edge : table.mEdges) {
+            std::shared_ptr<Data> data;
+            for (std::size_t ii = 0; previous && ii < previous->mEdges.size(); ++ii) {
+                if (previous->mEdges[ii].transition == edge.transition) {
+                    data = std::move(mTransitionData[ii]);
+                    break;
+                }
+            }
+            transitionData.push_back(data ? std::move(data) : edge.transition->makeData());
+        }
+    }
+    mStateData.swap(stateData);
+    mTransitionData.swap(transitionData);
+}
+
+void StateComponent::makeStateCurrent(int state)
 {
+    const TransitionTable& table = *mTable;
+
     mCurrentState = state;
 
-    mCurrentState->onEnter();
+    table.mStates[mCurrentState]->onEnter(mStateData[mCurrentState].get());
 
-    auto range = mTransitionMap.equal_range(mCurrentState);
-    for (auto ii = range.first; ii != range.second; ++ii) {
-        ii->second.second->onEnterState();
+    const int end = table.mFirstEdge[mCurrentState + 1];
+    for (int ii = table.mFirstEdge[mCurrentState]; ii != end; ++ii) {
+        table.mEdges[ii].transition->onEnterState(mTransitionData[ii].get());
+    }
+}
+
+int StateComponent::TransitionTable::stateId(const State* state) const
+{
+    for (size_t ii = 0; ii < mStates.size(); ++ii) {
+        if (mStates[ii].get() == state) {
+            return int(ii);
+        }
     }
+    return -1;
+}
+
+StateComponent::Data::~Data()
+{
+}
+
+void StateComponent::Data::save(Snapshot& snapshot) const
+{
+}
+
+void StateComponent::Data::load(SnapshotReader& reader)
+{
 }
 
 StateComponent::State::~State()
 {
 }
 
-void StateComponent::State::onEnter()
+std::shared_ptr<StateComponent::Data> StateComponent::State::makeData() const
+{
+    return nullptr;
+}
+
+void StateComponent::State::onEnter(Data* data) const
 {
 }
 
@@ -64,6 +230,11 @@ StateComponent::Transition::~Transition()
 {
 }
 
-void StateComponent::Transition::onEnterState()
+std::shared_ptr<StateComponent::Data> StateComponent::Transition::makeData() const
+{
+    return nullptr;
+}
+
+void StateComponent::Transition::onEnterState(Data* data) const
 {
 }
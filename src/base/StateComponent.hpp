@@ -1,28 +1,75 @@
 #ifndef BASE_STATE_COMPONENT
 #define BASE_STATE_COMPONENT
 
-#include "base/GenericComponent.hpp"
+#include "base/AIComponent.hpp"
 #include <map>
 #include <memory>
 #include <vector>
 
 //! \brief A component that uses states to determine its behavior.
-class StateComponent : public GenericComponent {
+class StateComponent : public AIComponent {
 public:
+    //! \brief Per-agent data of a state or transition. A table's states and
+    //! transitions can be shared by many components, so whatever changes as
+    //! one agent runs them (progress, timers, sensor ids) lives in a block
+    //! each component makes for itself and hands back on every call.
+    class Data {
+    public:
+        static constexpr Memory::Category MEMORY_CATEGORY = Memory::AI;
+
+        virtual ~Data();
+        virtual void save(Snapshot& snapshot) const; //!< write the data to a snapshot
+        virtual void load(SnapshotReader& reader); //!< read back what save wrote
+    };
+
     //! \behavior A state in the state machine.
     class State {
     public:
+        static constexpr Memory::Category MEMORY_CATEGORY = Memory::AI;
+        using Data = StateComponent::Data;
+
         virtual ~State() = 0;
-        virtual void onEnter(); //!< called when entering state
-        virtual void update(GameObject& gameObject, Level& level) = 0; //!< called to update when this is the current state
+        virtual std::shared_ptr<Data> makeData() const; //!< make the per-agent data of the state, if it has any
+        virtual void onEnter(Data* data) const; //!< called when entering state
+        virtual void update(GameObject& gameObject, Level& level, Data* data) const = 0; //!< called to update when this is the current state
     };
 
     //! \behavior A transition in the state machine.
     class Transition {
     public:
+        static constexpr Memory::Category MEMORY_CATEGORY = Memory::AI;
+        using Data = StateComponent::Data;
+
         virtual ~Transition() = 0;
-        virtual void onEnterState(); //!< called when entering state
-        virtual bool shouldTrigger(GameObject& gameObject, Level& level) = 0; //!< called to check if this transition should be followed
+        virtual std::shared_ptr<Data> makeData() const; //!< make the per-agent data of the transition, if it has any
+        virtual void onEnterState(Data* data) const; //!< called when entering state
+        virtual bool shouldTrigger(GameObject& gameObject, Level& level, Data* data) const = 0; //!< called to check if this transition should be followed
+    };
+
+    //! \brief A frozen state machine. States are numbered densely from 0
+    //! (the start state) and the outgoing transitions of each state sit next
+    //! to each other in one array, in the order they were added. A table can
+    //! be shared by many components; each keeps the Data of the table's
+    //! states and transitions for itself.
+    class TransitionTable {
+    public:
+        inline int stateCount() const { return int(mStates.size()); }
+        inline const std::shared_ptr<State>& state(int id) const { return mStates[id]; }
+        int stateId(const State* state) const; //!< Get the id of a state, or -1 if it is not in the table.
+
+    private:
+        friend class StateComponent;
+
+        //! \brief An outgoing transition and the id of its destination state.
+        struct Edge {
+            Transition* transition;
+            int to;
+        };
+
+        std::vector<std::shared_ptr<State>> mStates; //!< states by id
+        std::vector<int> mFirstEdge; //!< index of each state's first edge, plus the end of the last state's edges
+        std::vector<Edge> mEdges; //!< all edges, grouped by source state
+        std::vector<std::shared_ptr<Transition>> mTransitions; //!< keeps the transitions in mEdges alive
     };
 
     StateComponent(GameObject& gameObject);
@@ -30,15 +77,29 @@ public:
     void setStartState(std::shared_ptr<State> state);
     void addTransition(std::shared_ptr<State> stateFrom, std::shared_ptr<State> stateTo, std::shared_ptr<Transition> transition);
 
-    virtual void update(Level& level) override;
+    std::shared_ptr<const TransitionTable> compile() const; //!< Freeze the start state and transitions added so far into a table.
+    void setTransitionTable(std::shared_ptr<const TransitionTable> table); //!< Run from a (possibly shared) table instead of compiling our own.
+
+    virtual void think(Level& level) override;
+
+    virtual void save(Snapshot& snapshot) const override;
+    virtual void load(SnapshotReader& reader) override;
 
 private:
-    void makeStateCurrent(std::shared_ptr<State> state); //!< transtion to the given state
+    void makeStateCurrent(int state); //!< transtion to the given state
+    void makeData(const TransitionTable* previous); //!< make the data of mTable's states and transitions, keeping what previous had for those it shares
 
-    std::shared_ptr<State> mCurrentState; //!< the current state
+    int mCurrentState; //!< id of the current state in mTable, or -1 before starting
     std::shared_ptr<State> mStartState; //!< the start state
 
     std::multimap<std::shared_ptr<State>, std::pair<std::shared_ptr<State>, std::shared_ptr<Transition>>> mTransitionMap; //!< a map from states to their outgoing transitions and their destination state
+
+    std::shared_ptr<const TransitionTable> mTable; //!< the table being run; compiled on first update if not set
+    bool mOwnTable; //!< if mTable was compiled from mStartState and mTransitionMap
+    bool mTableStale; //!< if our own table must be recompiled because states or transitions were added
+
+    std::vector<std::shared_ptr<Data>> mStateData; //!< data of mTable's states, by id
+    std::vector<std::shared_ptr<Data>> mTransitionData; //!< data of mTable's transitions, by edge
 };
 
 #endif
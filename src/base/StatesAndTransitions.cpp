@@ -2,47 +2,18 @@
 #include "RectRenderComponent.hpp"
 #include "base/GameObject.hpp"
 #include "base/Level.hpp"
+#include "base/Pool.hpp"
+#include "base/Snapshot.hpp"
+#include "base/Steering.hpp"
 #include <cmath>
 
 // std::make_shared<RectRenderComponent>(*this, 0xdd, 0x22, 0x22)
 
-// move the gameObject toward x,y at speed
-// return true if the point to move toward is reached
-static bool moveToward(GameObject& gameObject, float x, float y, float speed)
-{
-    const float epsilon = 0.01;
-
-    float dX = x - gameObject.x();
-    float dY = y - gameObject.y();
-    const float len = sqrtf(dX * dX + dY * dY);
-    if (len < epsilon) {
-        return true;
-    } else {
-        const float scale = std::min(len, speed);
-        dX = dX / len * scale;
-        dY = dY / len * scale;
-
-        gameObject.setX(gameObject.x() + dX);
-        gameObject.setY(gameObject.y() + dY);
-
-        return (speed >= len - epsilon);
-    }
-}
-
-// return true if gameobject is less than distance from x,y
-static bool isNear(const GameObject& gameObject, float x, float y, float distance)
-{
-    const float dX = x - gameObject.x();
-    const float dY = y - gameObject.y();
-    const float lensqr = dX * dX + dY * dY;
-    return lensqr <= distance * distance;
-}
-
 IdleState::IdleState()
 {
 }
 
-void IdleState::update(GameObject& gameObject, Level& level)
+void IdleState::update(GameObject& gameObject, Level& level, Data* data) const
 {
 }
 
@@ -52,24 +23,39 @@ PatrolState::PatrolState(float speed, float x0, float y0, float x1, float y1)
     , mY0(y0)
     , mX1(x1)
     , mY1(y1)
-    , mForward(true)
 {
 }
 
-void PatrolState::onEnter()
+std::shared_ptr<StateComponent::Data> PatrolState::makeData() const
 {
-    mForward = true;
+    return makePooled<Progress>();
 }
 
-void PatrolState::update(GameObject& gameObject, Level& level)
+void PatrolState::onEnter(Data* data) const
+{
+    static_cast<Progress*>(data)->forward = true;
+}
+
+void PatrolState::update(GameObject& gameObject, Level& level, Data* data) const
 {
     // TODO PART 2: implement patrolling (using moveToward)
-    float tx = mForward ? mX1 : mX0;
-    float ty = mForward ? mY1 : mY0;
-    if (moveToward(gameObject, tx, ty, mSpeed)) {
-        mForward = !mForward;
+    Progress& progress = *static_cast<Progress*>(data);
+    float tx = progress.forward ? mX1 : mX0;
+    float ty = progress.forward ? mY1 : mY0;
+    if (moveToward(gameObject, tx, ty, mSpeed * level.ai().elapsed())) {
+        progress.forward = !progress.forward;
     }
-    gameObject.setRenderCompenent(std::make_shared<RectRenderComponent>(gameObject, 0xff, 0x22, 0x22));
+    gameObject.setColor(0xff, 0x22, 0x22);
+}
+
+void PatrolState::Progress::save(Snapshot& snapshot) const
+{
+    snapshot.write(forward);
+}
+
+void PatrolState::Progress::load(SnapshotReader& reader)
+{
+    reader.read(forward);
 }
 
 ChaseState::ChaseState(float speed, std::weak_ptr<GameObject> which)
@@ -78,14 +64,14 @@ ChaseState::ChaseState(float speed, std::weak_ptr<GameObject> which)
 {
 }
 
-void ChaseState::update(GameObject& gameObject, Level& level)
+void ChaseState::update(GameObject& gameObject, Level& level, Data* data) const
 {
     std::shared_ptr<GameObject> whichShared = mWhich.lock();
 
     if (whichShared) {
-        moveToward(gameObject, whichShared->x(), whichShared->y(), mSpeed);
+        level.flowField().steer(gameObject, *whichShared, mSpeed * level.ai().elapsed(), level.steering());
     }
-    gameObject.setRenderCompenent(std::make_shared<RectRenderComponent>(gameObject, 0x22, 0x22, 0xff));
+    gameObject.setColor(0x22, 0x22, 0xff);
 }
 
 MoveState::MoveState(float speed, float x, float y)
@@ -95,29 +81,97 @@ MoveState::MoveState(float speed, float x, float y)
 {
 }
 
-void MoveState::update(GameObject& gameObject, Level& level)
+void MoveState::update(GameObject& gameObject, Level& level, Data* data) const
+{
+    level.steering().queue(gameObject, mX, mY, mSpeed * level.ai().elapsed());
+    gameObject.setColor(0xff, 0x22, 0xff);
+}
+
+FollowPathState::FollowPathState(float speed, float x, float y)
+    : mSpeed(speed)
+    , mX(x)
+    , mY(y)
+{
+}
+
+std::shared_ptr<StateComponent::Data> FollowPathState::makeData() const
 {
-    moveToward(gameObject, mX, mY, mSpeed);
-    gameObject.setRenderCompenent(std::make_shared<RectRenderComponent>(gameObject, 0xff, 0x22, 0xff));
+    return makePooled<Progress>();
+}
+
+void FollowPathState::onEnter(Data* data) const
+{
+    static_cast<Progress*>(data)->follower.reset();
+}
+
+void FollowPathState::update(GameObject& gameObject, Level& level, Data* data) const
+{
+    static_cast<Progress*>(data)->follower.step(level, gameObject, mX, mY, mSpeed * level.ai().elapsed());
+    gameObject.setColor(0x22, 0xff, 0xff);
+}
+
+void FollowPathState::Progress::load(SnapshotReader& reader)
+{
+    follower.reset();
+}
+
+SeekSafetyState::SeekSafetyState(float speed, int tag, float searchRadius)
+    : mSpeed(speed)
+    , mTag(tag)
+    , mSearchRadius(searchRadius)
+{
+}
+
+void SeekSafetyState::update(GameObject& gameObject, Level& level, Data* data) const
+{
+    float cx = gameObject.x() + gameObject.w() * 0.5f;
+    float cy = gameObject.y() + gameObject.h() * 0.5f;
+    float sx, sy;
+    if (level.influence().safestPoint(mTag, cx, cy, mSearchRadius, &level.navGrid(), sx, sy)) {
+        level.steering().queue(gameObject, sx - gameObject.w() * 0.5f, sy - gameObject.h() * 0.5f, mSpeed * level.ai().elapsed());
+    }
+    gameObject.setColor(0xff, 0x88, 0x22);
 }
 
 WanderState::WanderState(float speed)
     : mSpeed(speed)
 {
-    targetX = rand() % 20 + 1;
-    targetY = rand() % 20 + 1;
-    steps = 0;
 }
 
-void WanderState::update(GameObject& gameObject, Level& level)
+std::shared_ptr<StateComponent::Data> WanderState::makeData() const
+{
+    return makePooled<Progress>();
+}
+
+void WanderState::update(GameObject& gameObject, Level& level, Data* data) const
 {
-    if (++steps > 120) {
-        targetX = (rand() % 20 + 1) * 40;
-        targetY = (rand() % 20 + 1) * 40;
-        steps = 0;
+    Progress& progress = *static_cast<Progress*>(data);
+    if (progress.targetX < 0.0f) {
+        progress.targetX = level.random().next(20) + 1;
+        progress.targetY = level.random().next(20) + 1;
     }
-    moveToward(gameObject, targetX, targetY, mSpeed);
-    gameObject.setRenderCompenent(std::make_shared<RectRenderComponent>(gameObject, 0xff, 0xff, 0xff));
+    progress.steps += level.ai().elapsed();
+    if (progress.steps > 120) {
+        progress.targetX = (level.random().next(20) + 1) * 40;
+        progress.targetY = (level.random().next(20) + 1) * 40;
+        progress.steps = 0;
+    }
+    level.steering().queue(gameObject, progress.targetX, progress.targetY, mSpeed * level.ai().elapsed());
+    gameObject.setColor(0xff, 0xff, 0xff);
+}
+
+void WanderState::Progress::save(Snapshot& snapshot) const
+{
+    snapshot.write(targetX);
+    snapshot.write(targetY);
+    snapshot.write(steps);
+}
+
+void WanderState::Progress::load(SnapshotReader& reader)
+{
+    reader.read(targetX);
+    reader.read(targetY);
+    reader.read(steps);
 }
 
 ObjectProximityTransition::ObjectProximityTransition(std::weak_ptr<GameObject> which, float distance)
@@ -126,12 +180,17 @@ ObjectProximityTransition::ObjectProximityTransition(std::weak_ptr<GameObject> w
 {
 }
 
-bool ObjectProximityTransition::shouldTrigger(GameObject& gameObject, Level& level)
+std::shared_ptr<StateComponent::Data> ObjectProximityTransition::makeData() const
 {
-    // TODO PART 3: check the level still has the game object being checked, and this gameObject is near it
-    std::shared_ptr<GameObject> whichShared = mWhich.lock();
+    return makePooled<SensorData>();
+}
 
-    return (whichShared && level.hasObject(whichShared) && isNear(gameObject, whichShared->x(), whichShared->y(), mDistance));
+bool ObjectProximityTransition::shouldTrigger(GameObject& gameObject, Level& level, Data* data) const
+{
+    // the sensor also checks the level still has the game object being checked
+    int& sensor = static_cast<SensorData*>(data)->sensor;
+    sensor = level.sensors().ensure(sensor, gameObject, mWhich, mDistance);
+    return level.sensors().isNear(sensor);
 }
 
 PointProximityTransition::PointProximityTransition(float x, float y, float distance)
@@ -141,24 +200,72 @@ PointProximityTransition::PointProximityTransition(float x, float y, float dista
 {
 }
 
-bool PointProximityTransition::shouldTrigger(GameObject& gameObject, Level& level)
+std::shared_ptr<StateComponent::Data> PointProximityTransition::makeData() const
 {
-    return isNear(gameObject, mX, mY, mDistance);
+    return makePooled<SensorData>();
+}
+
+bool PointProximityTransition::shouldTrigger(GameObject& gameObject, Level& level, Data* data) const
+{
+    int& sensor = static_cast<SensorData*>(data)->sensor;
+    sensor = level.sensors().ensure(sensor, gameObject, mX, mY, mDistance);
+    return level.sensors().isNear(sensor);
+}
+
+TagProximityTransition::TagProximityTransition(int tag, float distance)
+    : mTag(tag)
+    , mDistance(distance)
+{
+}
+
+bool TagProximityTransition::shouldTrigger(GameObject& gameObject, Level& level, Data* data) const
+{
+    float cx = gameObject.x() + gameObject.w() * 0.5f;
+    float cy = gameObject.y() + gameObject.h() * 0.5f;
+    return level.objectsInRadius(cx, cy, mDistance, mTag, nullptr, 0, &gameObject) > 0;
+}
+
+ThreatTransition::ThreatTransition(int tag, float threshold)
+    : mTag(tag)
+    , mThreshold(threshold)
+{
+}
+
+bool ThreatTransition::shouldTrigger(GameObject& gameObject, Level& level, Data* data) const
+{
+    float cx = gameObject.x() + gameObject.w() * 0.5f;
+    float cy = gameObject.y() + gameObject.h() * 0.5f;
+    return level.influence().influence(mTag, cx, cy) >= mThreshold;
 }
 
 TimedTransition::TimedTransition(int steps)
     : mSteps(steps)
-    , mStep(0)
 {
 }
 
-void TimedTransition::onEnterState()
+std::shared_ptr<StateComponent::Data> TimedTransition::makeData() const
+{
+    return makePooled<Progress>();
+}
+
+void TimedTransition::onEnterState(Data* data) const
+{
+    static_cast<Progress*>(data)->step = 0;
+}
+
+bool TimedTransition::shouldTrigger(GameObject& gameObject, Level& level, Data* data) const
+{
+    int& step = static_cast<Progress*>(data)->step;
+    step += int(level.ai().elapsed());
+    return step >= mSteps;
+}
+
+void TimedTransition::Progress::save(Snapshot& snapshot) const
 {
-    mStep = 0;
+    snapshot.write(step);
 }
 
-bool TimedTransition::shouldTrigger(GameObject& gameObject, Level& level)
+void TimedTransition::Progress::load(SnapshotReader& reader)
 {
-    ++mStep;
-    return mStep >= mSteps;
+    reader.read(step);
 }
@@ -1,6 +1,7 @@
 #ifndef BASE_STATES
 #define BASE_STATES
 
+#include "base/Pathfinder.hpp"
 #include "base/StateComponent.hpp"
 #include <memory>
 
@@ -11,7 +12,7 @@ class IdleState : public StateComponent::State {
 public:
     IdleState();
 
-    virtual void update(GameObject& gameObject, Level& level) override;
+    virtual void update(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
 };
@@ -21,14 +22,21 @@ class PatrolState : public StateComponent::State {
 public:
     PatrolState(float speed, float x0, float y0, float x1, float y1);
 
-    virtual void onEnter() override;
-    virtual void update(GameObject& gameObject, Level& level) override;
+    virtual std::shared_ptr<Data> makeData() const override;
+    virtual void onEnter(Data* data) const override;
+    virtual void update(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
+    //! \brief Which end an agent is heading for.
+    struct Progress : public Data {
+        bool forward = true;
+
+        virtual void save(Snapshot& snapshot) const override;
+        virtual void load(SnapshotReader& reader) override;
+    };
+
     const float mSpeed;
     const float mX0, mY0, mX1, mY1;
-
-    bool mForward;
 };
 
 //! \brief A state to chase something
@@ -36,7 +44,7 @@ class ChaseState : public StateComponent::State {
 public:
     ChaseState(float speed, std::weak_ptr<GameObject> which);
 
-    virtual void update(GameObject& gameObject, Level& level) override;
+    virtual void update(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
     const float mSpeed;
@@ -48,33 +56,82 @@ class MoveState : public StateComponent::State {
 public:
     MoveState(float speed, float x, float y);
 
-    virtual void update(GameObject& gameObject, Level& level) override;
+    virtual void update(GameObject& gameObject, Level& level, Data* data) const override;
+
+private:
+    const float mSpeed;
+    const float mX, mY;
+};
+
+//! \brief A state to move somewhere along a path around obstacles
+class FollowPathState : public StateComponent::State {
+public:
+    FollowPathState(float speed, float x, float y);
+
+    virtual std::shared_ptr<Data> makeData() const override;
+    virtual void onEnter(Data* data) const override;
+    virtual void update(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
+    //! \brief An agent's path; not saved, it is found again after a load.
+    struct Progress : public Data {
+        PathFollower follower;
+
+        virtual void load(SnapshotReader& reader) override;
+    };
+
     const float mSpeed;
     const float mX, mY;
 };
 
+//! \brief A state to move to the place nearby least influenced by a tag
+class SeekSafetyState : public StateComponent::State {
+public:
+    SeekSafetyState(float speed, int tag, float searchRadius);
+
+    virtual void update(GameObject& gameObject, Level& level, Data* data) const override;
+
+private:
+    const float mSpeed;
+    const int mTag;
+    const float mSearchRadius;
+};
+
 class WanderState : public StateComponent::State {
 public:
     WanderState(float speed);
 
-    virtual void update(GameObject& gameObject, Level& level) override;
+    virtual std::shared_ptr<Data> makeData() const override;
+    virtual void update(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
+    //! \brief Where an agent is wandering to, and for how long it has.
+    struct Progress : public Data {
+        // the first target is picked on the first update, from the level's generator
+        float targetX = -1.0f, targetY = -1.0f;
+        float steps = 0;
+
+        virtual void save(Snapshot& snapshot) const override;
+        virtual void load(SnapshotReader& reader) override;
+    };
+
     const float mSpeed;
-    float targetX, targetY;
-    float steps;
 };
 
 // ********** TRANSITIONS **********
 
+//! \brief The per-agent data of a transition that checks a proximity sensor.
+struct SensorData : public StateComponent::Data {
+    int sensor = -1; //!< the agent's sensor in the level's proximity sensors
+};
+
 //! \brief A transition that triggers when near another gameobject
 class ObjectProximityTransition : public StateComponent::Transition {
 public:
     ObjectProximityTransition(std::weak_ptr<GameObject> which, float distance);
 
-    virtual bool shouldTrigger(GameObject& gameObject, Level& level) override;
+    virtual std::shared_ptr<Data> makeData() const override;
+    virtual bool shouldTrigger(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
     const std::weak_ptr<GameObject> mWhich;
@@ -86,24 +143,57 @@ class PointProximityTransition : public StateComponent::Transition {
 public:
     PointProximityTransition(float x, float y, float distance);
 
-    virtual bool shouldTrigger(GameObject& gameObject, Level& level) override;
+    virtual std::shared_ptr<Data> makeData() const override;
+    virtual bool shouldTrigger(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
     const float mX, mY;
     const float mDistance;
 };
 
+//! \brief A transition that triggers when any other gameobject with a tag is near
+class TagProximityTransition : public StateComponent::Transition {
+public:
+    TagProximityTransition(int tag, float distance);
+
+    virtual bool shouldTrigger(GameObject& gameObject, Level& level, Data* data) const override;
+
+private:
+    const int mTag;
+    const float mDistance;
+};
+
+//! \brief A transition that triggers when the influence of a tag where the gameobject is reaches a threshold
+class ThreatTransition : public StateComponent::Transition {
+public:
+    ThreatTransition(int tag, float threshold);
+
+    virtual bool shouldTrigger(GameObject& gameObject, Level& level, Data* data) const override;
+
+private:
+    const int mTag;
+    const float mThreshold;
+};
+
 //! \brief A transition that triggers after a certain time
 class TimedTransition : public StateComponent::Transition {
 public:
     TimedTransition(int steps);
 
-    virtual void onEnterState() override;
-    virtual bool shouldTrigger(GameObject& gameObject, Level& level) override;
+    virtual std::shared_ptr<Data> makeData() const override;
+    virtual void onEnterState(Data* data) const override;
+    virtual bool shouldTrigger(GameObject& gameObject, Level& level, Data* data) const override;
 
 private:
+    //! \brief The steps an agent has spent in the state.
+    struct Progress : public Data {
+        int step = 0;
+
+        virtual void save(Snapshot& snapshot) const override;
+        virtual void load(SnapshotReader& reader) override;
+    };
+
     const int mSteps;
-    int mStep;
 };
 
 #endif
@@ -0,0 +1,134 @@
+#include "base/Stats.hpp"
+#include <algorithm>
+#include <bit>
+
+void StatHistogram::record(std::uint64_t sample)
+{
+    const int b = std::min(int(std::bit_width(sample)), BUCKETS - 1);
+    mBuckets[b].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(sample, std::memory_order_relaxed);
+    std::uint64_t seen = mMax.load(std::memory_order_relaxed);
+    while (sample > seen && !mMax.compare_exchange_weak(seen, sample, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t StatHistogram::bucketLimit(int b)
+{
+    if (b >= BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    return (std::uint64_t(1) << b) - 1;
+}
+
+Stats& Stats::global()
+{
+    static Stats stats;
+    return stats;
+}
+
+template <typename Stat>
+static Stat& findOrAdd(std::map<std::string, std::unique_ptr<Stat>>& stats, const std::string& name)
+{
+    std::unique_ptr<Stat>& stat = stats[name];
+    if (!stat) {
+        stat = std::make_unique<Stat>();
+    }
+    return *stat;
+}
+
+StatCounter& Stats::counter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return findOrAdd(mCounters, name);
+}
+
+StatGauge& Stats::gauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return findOrAdd(mGauges, name);
+}
+
+StatHistogram& Stats::histogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return findOrAdd(mHistograms, name);
+}
+
+static void writeName(std::ostream& out, const std::string& name)
+{
+    out << '"';
+    for (char c : name) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+void Stats::writeJson(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const char* sep = "";
+    out << "{\"counters\":{";
+    for (auto& counter : mCounters) {
+        out << sep;
+        writeName(out, counter.first);
+        out << ':' << counter.second->value();
+        sep = ",";
+    }
+
+    sep = "";
+    out << "},\"gauges\":{";
+    for (auto& gauge : mGauges) {
+        out << sep;
+        writeName(out, gauge.first);
+        out << ':' << gauge.second->value();
+        sep = ",";
+    }
+
+    // buckets as [largest sample, count] pairs, leaving out empty ones
+    sep = "";
+    out << "},\"histograms\":{";
+    for (auto& histogram : mHistograms) {
+        const StatHistogram& h = *histogram.second;
+        out << sep;
+        writeName(out, histogram.first);
+        out << ":{\"count\":" << h.count() << ",\"sum\":" << h.sum() << ",\"max\":" << h.max() << ",\"buckets\":[";
+        const char* bucketSep = "";
+        for (int b = 0; b < StatHistogram::BUCKETS; ++b) {
+            if (std::uint64_t n = h.bucket(b)) {
+                out << bucketSep << '[' << StatHistogram::bucketLimit(b) << ',' << n << ']';
+                bucketSep = ",";
+            }
+        }
+        out << "]}";
+        sep = ",";
+    }
+    out << "}}\n";
+}
+
+void Stats::writeText(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto& counter : mCounters) {
+        out << counter.first << ' ' << counter.second->value() << '\n';
+    }
+    for (auto& gauge : mGauges) {
+        out << gauge.first << ' ' << gauge.second->value() << '\n';
+    }
+    for (auto& histogram : mHistograms) {
+        const StatHistogram& h = *histogram.second;
+        out << histogram.first << ".count " << h.count() << '\n';
+        out << histogram.first << ".sum " << h.sum() << '\n';
+        out << histogram.first << ".max " << h.max() << '\n';
+        for (int b = 0; b < StatHistogram::BUCKETS; ++b) {
+            if (std::uint64_t n = h.bucket(b)) {
+                out << histogram.first << ".le_" << StatHistogram::bucketLimit(b) << ' ' << n << '\n';
+            }
+        }
+    }
+}
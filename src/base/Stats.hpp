@@ -0,0 +1,85 @@
+#ifndef BASE_STATS
+#define BASE_STATS
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+//! \brief A running total, such as ticks run.
+class StatCounter {
+public:
+    inline void add(std::uint64_t n = 1) { mValue.fetch_add(n, std::memory_order_relaxed); }
+    inline std::uint64_t value() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> mValue { 0 };
+};
+
+//! \brief A value that goes up and down, such as objects in play.
+class StatGauge {
+public:
+    inline void set(std::int64_t value) { mValue.store(value, std::memory_order_relaxed); }
+    inline void add(std::int64_t n) { mValue.fetch_add(n, std::memory_order_relaxed); }
+    inline std::int64_t value() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> mValue { 0 };
+};
+
+//! \brief A distribution of samples, such as tick times, in power-of-two
+//! buckets: bucket 0 counts zeros and bucket b counts samples below 2^b and
+//! at least 2^(b - 1).
+class StatHistogram {
+public:
+    static const int BUCKETS = 40;
+
+    void record(std::uint64_t sample);
+
+    inline std::uint64_t count() const { return mCount.load(std::memory_order_relaxed); }
+    inline std::uint64_t sum() const { return mSum.load(std::memory_order_relaxed); }
+    inline std::uint64_t max() const { return mMax.load(std::memory_order_relaxed); }
+    inline std::uint64_t bucket(int b) const { return mBuckets[b].load(std::memory_order_relaxed); }
+    static std::uint64_t bucketLimit(int b); //!< Get the largest sample a bucket counts.
+
+private:
+    std::atomic<std::uint64_t> mBuckets[BUCKETS] = {};
+    std::atomic<std::uint64_t> mCount { 0 };
+    std::atomic<std::uint64_t> mSum { 0 };
+    std::atomic<std::uint64_t> mMax { 0 };
+};
+
+//! \brief The process's named runtime statistics. Looking a statistic up
+//! takes a lock and is meant for setup: code that reports keeps the
+//! reference it gets back, which stays valid for the life of the process,
+//! and updating it is a relaxed atomic operation that never blocks. Levels
+//! running on several threads share their statistics and add up.
+//!
+//! Snapshots read every value without stopping writers, so values taken in
+//! the middle of a tick may be from either side of it.
+class Stats {
+public:
+    static Stats& global();
+
+    StatCounter& counter(const std::string& name); //!< Get a counter, creating it at zero.
+    StatGauge& gauge(const std::string& name); //!< Get a gauge, creating it at zero.
+    StatHistogram& histogram(const std::string& name); //!< Get a histogram, creating it empty.
+
+    void writeJson(std::ostream& out) const; //!< Write every statistic as one JSON object.
+    void writeText(std::ostream& out) const; //!< Write every statistic, one "name value" line each.
+
+private:
+    Stats() = default;
+    Stats(const Stats&) = delete;
+    void operator=(Stats const&) = delete;
+
+    mutable std::mutex mMutex;
+    std::map<std::string, std::unique_ptr<StatCounter>> mCounters;
+    std::map<std::string, std::unique_ptr<StatGauge>> mGauges;
+    std::map<std::string, std::unique_ptr<StatHistogram>> mHistograms;
+};
+
+#endif
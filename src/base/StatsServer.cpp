@@ -0,0 +1,156 @@
+#include "base/StatsServer.hpp"
+#include "base/Stats.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// how long the thread waits before checking if it should stop, how long a
+// client has to ask for text before getting JSON, and how long it may stall
+// taking its snapshot before it is dropped, in milliseconds
+static const int POLL_TIME = 100;
+static const int REQUEST_TIME = 50;
+static const int SEND_TIME = 1000;
+
+StatsServer::StatsServer()
+    : mStopping(false)
+    , mSocket(-1)
+{
+}
+
+StatsServer::~StatsServer()
+{
+    stop();
+}
+
+bool StatsServer::start(const std::string& path, std::string& error)
+{
+    stop();
+
+#ifndef _WIN32
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "bad stats socket path " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+    // only a socket, presumably left by an earlier run, is replaced
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            error = "not replacing " + path + ", which is not a socket";
+            return false;
+        }
+        ::unlink(path.c_str());
+    }
+
+    mSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (mSocket < 0) {
+        error = "cannot create stats socket";
+        return false;
+    }
+    if (bind(mSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(mSocket, 8) != 0) {
+        ::close(mSocket);
+        mSocket = -1;
+        error = "cannot listen on " + path;
+        return false;
+    }
+
+    mPath = path;
+    mStopping.store(false);
+    mThread = std::thread(&StatsServer::serve, this);
+    return true;
+#else
+    error = "stats sockets are not supported on this platform";
+    return false;
+#endif
+}
+
+void StatsServer::stop()
+{
+    if (!mThread.joinable()) {
+        return;
+    }
+    mStopping.store(true);
+    mThread.join();
+#ifndef _WIN32
+    ::close(mSocket);
+    ::unlink(mPath.c_str());
+#endif
+    mSocket = -1;
+    mPath.clear();
+}
+
+void StatsServer::serve()
+{
+#ifndef _WIN32
+    while (!mStopping.load()) {
+        pollfd listening = { mSocket, POLLIN, 0 };
+        if (poll(&listening, 1, POLL_TIME) <= 0) {
+            continue;
+        }
+        int client = accept(mSocket, nullptr, nullptr);
+        if (client >= 0) {
+            answer(client);
+            ::close(client);
+        }
+    }
+#endif
+}
+
+void StatsServer::answer(int client)
+{
+#ifndef _WIN32
+    bool text = false;
+    pollfd request = { client, POLLIN, 0 };
+    if (poll(&request, 1, REQUEST_TIME) > 0) {
+        char buffer[16];
+        ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+        text = n >= 4 && std::memcmp(buffer, "text", 4) == 0;
+    }
+
+    std::ostringstream out;
+    if (text) {
+        Stats::global().writeText(out);
+    } else {
+        Stats::global().writeJson(out);
+    }
+    const std::string snapshot = out.str();
+
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL; // a client hanging up early must not kill the game
+#else
+    const int flags = 0;
+    int noSigPipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+    // a client that stops reading must not hold the thread past a stop
+    timeval timeout = { 0, POLL_TIME * 1000 };
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int stalled = 0;
+    for (std::size_t sent = 0; sent < snapshot.size();) {
+        ssize_t n = send(client, snapshot.data() + sent, snapshot.size() - sent, flags);
+        if (n > 0) {
+            sent += std::size_t(n);
+            stalled = 0;
+            continue;
+        }
+        const bool timedOut = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        if (!timedOut || mStopping.load() || (stalled += POLL_TIME) >= SEND_TIME) {
+            break;
+        }
+    }
+#endif
+}
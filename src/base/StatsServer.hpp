@@ -0,0 +1,43 @@
+#ifndef BASE_STATS_SERVER
+#define BASE_STATS_SERVER
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+//! \brief Serves snapshots of Stats::global() on a local Unix domain socket,
+//! from a thread of its own, so the game thread never waits on a client.
+//! Each connection gets one snapshot and is closed: JSON by default, or
+//! "name value" lines if the client first sends "text". A client that
+//! stops reading is dropped after a second. For example:
+//!
+//!     socat - UNIX-CONNECT:/tmp/avoid.stats
+//!     echo text | socat - UNIX-CONNECT:/tmp/avoid.stats
+//!
+//! Not available on Windows, where start always fails.
+class StatsServer {
+public:
+    StatsServer();
+    ~StatsServer();
+
+    //! \brief Listen at a path, replacing a stale socket left there; fails
+    //! rather than replace anything else.
+    bool start(const std::string& path, std::string& error);
+    void stop(); //!< Stop serving and remove the socket.
+
+    inline bool running() const { return mThread.joinable(); }
+
+private:
+    StatsServer(const StatsServer&) = delete;
+    void operator=(StatsServer const&) = delete;
+
+    void serve();
+    void answer(int client);
+
+    std::thread mThread;
+    std::atomic<bool> mStopping;
+    std::string mPath;
+    int mSocket;
+};
+
+#endif
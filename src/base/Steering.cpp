@@ -0,0 +1,178 @@
+#include "base/Steering.hpp"
+#include "base/GameObject.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const float EPSILON = 0.01f;
+
+// the reference kernel; the vector versions below do the same operations in
+// the same order so that every lane rounds identically
+static inline void moveTowardOne(float x, float y, float tx, float ty, float speed, float& outX, float& outY, unsigned char& arrived)
+{
+    float dX = tx - x;
+    float dY = ty - y;
+    const float len = sqrtf(dX * dX + dY * dY);
+    if (len < EPSILON) {
+        outX = x;
+        outY = y;
+        arrived = 1;
+    } else {
+        const float scale = std::min(len, speed);
+        dX = dX / len * scale;
+        dY = dY / len * scale;
+
+        outX = x + dX;
+        outY = y + dY;
+        arrived = (speed >= len - EPSILON);
+    }
+}
+
+bool moveToward(GameObject& gameObject, float x, float y, float speed)
+{
+    float outX, outY;
+    unsigned char arrived;
+    moveTowardOne(gameObject.x(), gameObject.y(), x, y, speed, outX, outY, arrived);
+    gameObject.setX(outX);
+    gameObject.setY(outY);
+    return arrived;
+}
+
+bool isNear(const GameObject& gameObject, float x, float y, float distance)
+{
+    const float dX = x - gameObject.x();
+    const float dY = y - gameObject.y();
+    const float lensqr = dX * dX + dY * dY;
+    return lensqr <= distance * distance;
+}
+
+void moveTowardBatch(const float* x, const float* y, const float* tx, const float* ty, const float* speed,
+    float* outX, float* outY, unsigned char* arrived, size_t n)
+{
+    size_t ii = 0;
+
+#if defined(__AVX2__)
+    const __m256 eps = _mm256_set1_ps(EPSILON);
+    for (; ii + 8 <= n; ii += 8) {
+        const __m256 vx = _mm256_loadu_ps(x + ii);
+        const __m256 vy = _mm256_loadu_ps(y + ii);
+        const __m256 vs = _mm256_loadu_ps(speed + ii);
+        const __m256 dX = _mm256_sub_ps(_mm256_loadu_ps(tx + ii), vx);
+        const __m256 dY = _mm256_sub_ps(_mm256_loadu_ps(ty + ii), vy);
+        const __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dX, dX), _mm256_mul_ps(dY, dY)));
+        const __m256 tiny = _mm256_cmp_ps(len, eps, _CMP_LT_OQ);
+        const __m256 scale = _mm256_min_ps(vs, len);
+        const __m256 nx = _mm256_add_ps(vx, _mm256_mul_ps(_mm256_div_ps(dX, len), scale));
+        const __m256 ny = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_div_ps(dY, len), scale));
+        _mm256_storeu_ps(outX + ii, _mm256_blendv_ps(nx, vx, tiny));
+        _mm256_storeu_ps(outY + ii, _mm256_blendv_ps(ny, vy, tiny));
+        const int mask = _mm256_movemask_ps(_mm256_or_ps(tiny, _mm256_cmp_ps(vs, _mm256_sub_ps(len, eps), _CMP_GE_OQ)));
+        for (int lane = 0; lane < 8; ++lane) {
+            arrived[ii + lane] = (mask >> lane) & 1;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128 eps = _mm_set1_ps(EPSILON);
+    for (; ii + 4 <= n; ii += 4) {
+        const __m128 vx = _mm_loadu_ps(x + ii);
+        const __m128 vy = _mm_loadu_ps(y + ii);
+        const __m128 vs = _mm_loadu_ps(speed + ii);
+        const __m128 dX = _mm_sub_ps(_mm_loadu_ps(tx + ii), vx);
+        const __m128 dY = _mm_sub_ps(_mm_loadu_ps(ty + ii), vy);
+        const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dX, dX), _mm_mul_ps(dY, dY)));
+        const __m128 tiny = _mm_cmplt_ps(len, eps);
+        const __m128 scale = _mm_min_ps(vs, len);
+        const __m128 nx = _mm_add_ps(vx, _mm_mul_ps(_mm_div_ps(dX, len), scale));
+        const __m128 ny = _mm_add_ps(vy, _mm_mul_ps(_mm_div_ps(dY, len), scale));
+        _mm_storeu_ps(outX + ii, _mm_or_ps(_mm_and_ps(tiny, vx), _mm_andnot_ps(tiny, nx)));
+        _mm_storeu_ps(outY + ii, _mm_or_ps(_mm_and_ps(tiny, vy), _mm_andnot_ps(tiny, ny)));
+        const int mask = _mm_movemask_ps(_mm_or_ps(tiny, _mm_cmpge_ps(vs, _mm_sub_ps(len, eps))));
+        for (int lane = 0; lane < 4; ++lane) {
+            arrived[ii + lane] = (mask >> lane) & 1;
+        }
+    }
+#endif
+
+    for (; ii < n; ++ii) {
+        moveTowardOne(x[ii], y[ii], tx[ii], ty[ii], speed[ii], outX[ii], outY[ii], arrived[ii]);
+    }
+}
+
+void isNearBatch(const float* x, const float* y, const float* tx, const float* ty, const float* distance,
+    unsigned char* near, size_t n)
+{
+    size_t ii = 0;
+
+#if defined(__AVX2__)
+    for (; ii + 8 <= n; ii += 8) {
+        const __m256 dX = _mm256_sub_ps(_mm256_loadu_ps(tx + ii), _mm256_loadu_ps(x + ii));
+        const __m256 dY = _mm256_sub_ps(_mm256_loadu_ps(ty + ii), _mm256_loadu_ps(y + ii));
+        const __m256 d = _mm256_loadu_ps(distance + ii);
+        const __m256 lensqr = _mm256_add_ps(_mm256_mul_ps(dX, dX), _mm256_mul_ps(dY, dY));
+        const int mask = _mm256_movemask_ps(_mm256_cmp_ps(lensqr, _mm256_mul_ps(d, d), _CMP_LE_OQ));
+        for (int lane = 0; lane < 8; ++lane) {
+            near[ii + lane] = (mask >> lane) & 1;
+        }
+    }
+#elif defined(__SSE2__)
+    for (; ii + 4 <= n; ii += 4) {
+        const __m128 dX = _mm_sub_ps(_mm_loadu_ps(tx + ii), _mm_loadu_ps(x + ii));
+        const __m128 dY = _mm_sub_ps(_mm_loadu_ps(ty + ii), _mm_loadu_ps(y + ii));
+        const __m128 d = _mm_loadu_ps(distance + ii);
+        const __m128 lensqr = _mm_add_ps(_mm_mul_ps(dX, dX), _mm_mul_ps(dY, dY));
+        const int mask = _mm_movemask_ps(_mm_cmple_ps(lensqr, _mm_mul_ps(d, d)));
+        for (int lane = 0; lane < 4; ++lane) {
+            near[ii + lane] = (mask >> lane) & 1;
+        }
+    }
+#endif
+
+    for (; ii < n; ++ii) {
+        const float dX = tx[ii] - x[ii];
+        const float dY = ty[ii] - y[ii];
+        near[ii] = dX * dX + dY * dY <= distance[ii] * distance[ii];
+    }
+}
+
+void SteeringBatch::queue(GameObject& gameObject, float x, float y, float speed, bool* arrived)
+{
+    mObjects.push_back(&gameObject);
+    mArrivedOut.push_back(arrived);
+    mX.push_back(gameObject.x());
+    mY.push_back(gameObject.y());
+    mTX.push_back(x);
+    mTY.push_back(y);
+    mSpeed.push_back(speed);
+}
+
+void SteeringBatch::flush()
+{
+    const size_t n = mObjects.size();
+    if (n == 0) {
+        return;
+    }
+
+    mArrived.resize(n);
+    moveTowardBatch(mX.data(), mY.data(), mTX.data(), mTY.data(), mSpeed.data(), mX.data(), mY.data(), mArrived.data(), n);
+
+    for (size_t ii = 0; ii < n; ++ii) {
+        mObjects[ii]->setX(mX[ii]);
+        mObjects[ii]->setY(mY[ii]);
+        if (mArrivedOut[ii]) {
+            *mArrivedOut[ii] = mArrived[ii];
+        }
+    }
+
+    mObjects.clear();
+    mArrivedOut.clear();
+    mX.clear();
+    mY.clear();
+    mTX.clear();
+    mTY.clear();
+    mSpeed.clear();
+}
@@ -0,0 +1,46 @@
+#ifndef BASE_STEERING
+#define BASE_STEERING
+
+#include <cstddef>
+#include <vector>
+
+class GameObject;
+
+// move the gameObject toward x,y at speed
+// return true if the point to move toward is reached
+bool moveToward(GameObject& gameObject, float x, float y, float speed);
+
+// return true if gameobject is less than distance from x,y
+bool isNear(const GameObject& gameObject, float x, float y, float distance);
+
+//! \brief moveToward for n agents at once, over arrays of positions,
+//! targets and speeds. Writes the moved positions (outX/outY may be x/y) and
+//! arrival flags. Uses AVX2 or SSE2 when compiled for them, and gives
+//! exactly the same results as calling moveToward on each agent.
+void moveTowardBatch(const float* x, const float* y, const float* tx, const float* ty, const float* speed,
+    float* outX, float* outY, unsigned char* arrived, size_t n);
+
+//! \brief isNear for n agents at once; see moveTowardBatch.
+void isNearBatch(const float* x, const float* y, const float* tx, const float* ty, const float* distance,
+    unsigned char* near, size_t n);
+
+//! \brief Collects moveToward requests made during a tick and applies them
+//! together with moveTowardBatch. The level flushes it after updating all
+//! objects and before the physics step. Queue at most one move per object
+//! per tick; later moves start from the same position and overwrite it.
+class SteeringBatch {
+public:
+    //! \brief Queue a move. If arrived is given, it is set when the batch
+    //! is flushed to whether the target was reached.
+    void queue(GameObject& gameObject, float x, float y, float speed, bool* arrived = nullptr);
+
+    void flush(); //!< Move all queued objects and clear the queue.
+
+private:
+    std::vector<GameObject*> mObjects;
+    std::vector<bool*> mArrivedOut;
+    std::vector<float> mX, mY, mTX, mTY, mSpeed;
+    std::vector<unsigned char> mArrived;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "base/UniformGrid.hpp"
+
+// at most this many cells per indexed point, so sparse sets stay cheap
+static const int MAX_CELLS_PER_POINT = 4;
+static const int MIN_CELLS = 1024;
+
+UniformGrid::UniformGrid()
+    : mCellSize(1.0f)
+    , mInvCellSize(1.0f)
+    , mOriginX(0.0f)
+    , mOriginY(0.0f)
+    , mCols(0)
+    , mRows(0)
+{
+}
+
+void UniformGrid::build(const float* xs, const float* ys, int count, float cellSize)
+{
+    mEntries.clear();
+    mCellStart.clear();
+    mCellOf.resize(count);
+
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (int ii = 0; ii < count; ++ii) {
+        if (std::isfinite(xs[ii]) && std::isfinite(ys[ii])) {
+            minX = std::min(minX, xs[ii]);
+            minY = std::min(minY, ys[ii]);
+            maxX = std::max(maxX, xs[ii]);
+            maxY = std::max(maxY, ys[ii]);
+        }
+    }
+    if (!(minX <= maxX)) {
+        mCols = mRows = 0;
+        return;
+    }
+
+    // widen the cells until the grid is no bigger than the point set warrants
+    const double maxCells = std::max(double(count) * MAX_CELLS_PER_POINT, double(MIN_CELLS));
+    mCellSize = std::max(cellSize, 1e-3f);
+    while (true) {
+        const double cols = std::floor((maxX - minX) / mCellSize) + 1.0;
+        const double rows = std::floor((maxY - minY) / mCellSize) + 1.0;
+        if (cols * rows <= maxCells) {
+            mCols = int(cols);
+            mRows = int(rows);
+            break;
+        }
+        mCellSize *= 2.0f;
+    }
+    mInvCellSize = 1.0f / mCellSize;
+    mOriginX = minX;
+    mOriginY = minY;
+
+    // counting sort of the points by cell
+    mCellStart.assign(size_t(mCols) * mRows + 1, 0);
+    for (int ii = 0; ii < count; ++ii) {
+        if (std::isfinite(xs[ii]) && std::isfinite(ys[ii])) {
+            const int cx = std::min(int((xs[ii] - mOriginX) * mInvCellSize), mCols - 1);
+            const int cy = std::min(int((ys[ii] - mOriginY) * mInvCellSize), mRows - 1);
+            mCellOf[ii] = cy * mCols + cx;
+            ++mCellStart[mCellOf[ii] + 1];
+        } else {
+            mCellOf[ii] = -1;
+        }
+    }
+    for (size_t cell = 1; cell < mCellStart.size(); ++cell) {
+        mCellStart[cell] += mCellStart[cell - 1];
+    }
+    mEntries.resize(mCellStart.back());
+    mCursor.assign(mCellStart.begin(), mCellStart.end() - 1);
+    for (int ii = 0; ii < count; ++ii) {
+        if (mCellOf[ii] >= 0) {
+            mEntries[mCursor[mCellOf[ii]]++] = ii;
+        }
+    }
+}
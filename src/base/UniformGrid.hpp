@@ -0,0 +1,69 @@
+#ifndef BASE_UNIFORM_GRID
+#define BASE_UNIFORM_GRID
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//! \brief A spatial index over a set of points, rebuilt in bulk. Points are
+//! bucketed into square cells with a counting sort, so the entries of each
+//! cell are contiguous and a rebuild allocates nothing once the buffers have
+//! grown to fit.
+class UniformGrid {
+public:
+    UniformGrid();
+
+    //! \brief Index points 0..count-1. The cell size is a hint; it grows if
+    //! the points are spread so thin the grid would be mostly empty.
+    void build(const float* xs, const float* ys, int count, float cellSize);
+
+    inline float cellSize() const { return mCellSize; }
+
+    //! \brief Get if the rectangle covers every cell, so a query over it
+    //! visits every point.
+    inline bool covers(float x0, float y0, float x1, float y1) const
+    {
+        return mCols == 0 || (x0 <= mOriginX && y0 <= mOriginY && x1 >= mOriginX + mCols * mCellSize && y1 >= mOriginY + mRows * mCellSize);
+    }
+
+    //! \brief Call f(index) for every point in the cells overlapping the
+    //! rectangle. Cells are coarse, so f must still test the point itself.
+    template <typename F>
+    void query(float x0, float y0, float x1, float y1, F&& f) const
+    {
+        if (mEntries.empty() || !(x0 <= x1) || !(y0 <= y1)) {
+            return;
+        }
+        const float fx0 = std::floor((x0 - mOriginX) * mInvCellSize);
+        const float fy0 = std::floor((y0 - mOriginY) * mInvCellSize);
+        const float fx1 = std::floor((x1 - mOriginX) * mInvCellSize);
+        const float fy1 = std::floor((y1 - mOriginY) * mInvCellSize);
+        if (fx1 < 0.0f || fy1 < 0.0f || fx0 >= float(mCols) || fy0 >= float(mRows)) {
+            return;
+        }
+        const int cx0 = std::max(int(fx0), 0);
+        const int cy0 = std::max(int(fy0), 0);
+        const int cx1 = std::min(int(fx1), mCols - 1);
+        const int cy1 = std::min(int(fy1), mRows - 1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                const int cell = cy * mCols + cx;
+                for (int ii = mCellStart[cell]; ii < mCellStart[cell + 1]; ++ii) {
+                    f(mEntries[ii]);
+                }
+            }
+        }
+    }
+
+private:
+    float mCellSize, mInvCellSize;
+    float mOriginX, mOriginY;
+    int mCols, mRows;
+
+    std::vector<int> mCellStart; //!< index of each cell's first entry, plus the end of the last cell's entries
+    std::vector<int> mEntries; //!< point indices, grouped by cell
+    std::vector<int> mCellOf; //!< cell of each point, or -1 if the point was skipped
+    std::vector<int> mCursor; //!< next free entry of each cell while building
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "base/WorldRunner.hpp"
+#include "base/Level.hpp"
+#include <algorithm>
+
+WorldRunner::WorldRunner(unsigned threads)
+    : mBatch(0)
+    , mBusy(0)
+    , mStopping(false)
+    , mEpisode(nullptr)
+    , mSeeds(nullptr)
+    , mResults(nullptr)
+    , mNext(0)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    mThreads.reserve(threads);
+    for (unsigned ii = 0; ii < threads; ++ii) {
+        mThreads.emplace_back(&WorldRunner::work, this);
+    }
+}
+
+WorldRunner::~WorldRunner()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mStart.notify_all();
+    for (std::thread& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void WorldRunner::run(const Episode& episode, const std::vector<unsigned>& seeds, std::vector<Result>& results)
+{
+    results.resize(seeds.size());
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mEpisode = &episode;
+    mSeeds = &seeds;
+    mResults = &results;
+    mNext.store(0, std::memory_order_relaxed);
+    mBusy = unsigned(mThreads.size());
+    ++mBatch;
+    mStart.notify_all();
+    mFinished.wait(lock, [this] { return mBusy == 0; });
+    mEpisode = nullptr;
+    mSeeds = nullptr;
+    mResults = nullptr;
+}
+
+WorldRunner::Result WorldRunner::runEpisode(const Episode& episode, unsigned seed)
+{
+    Result result = { seed, 0, 0.0f, false };
+    std::shared_ptr<Level> level = episode.create(seed);
+    if (!level) {
+        return result;
+    }
+    level->random().seed(seed);
+
+    while (result.ticks < episode.maxTicks) {
+        if (episode.control) {
+            episode.control(*level, result.ticks);
+        }
+        level->update();
+        ++result.ticks;
+        if (episode.done(*level, result.score)) {
+            result.finished = true;
+            break;
+        }
+    }
+    return result;
+}
+
+void WorldRunner::work()
+{
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStart.wait(lock, [this, seen] { return mStopping || mBatch != seen; });
+            if (mStopping) {
+                return;
+            }
+            seen = mBatch;
+        }
+
+        // the batch's fields do not change until every worker has left it
+        for (std::size_t ii; (ii = mNext.fetch_add(1, std::memory_order_relaxed)) < mSeeds->size();) {
+            (*mResults)[ii] = runEpisode(*mEpisode, (*mSeeds)[ii]);
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mBusy == 0) {
+            mFinished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef BASE_WORLD_RUNNER
+#define BASE_WORLD_RUNNER
+
+#include <SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Level;
+
+//! \brief Runs many independent, seeded episodes of a level at once, for
+//! batch evaluation of AI. Each episode builds its own Level, whose
+//! blackboard, input and random number generator are its own, and steps it
+//! headless until it is over or runs out of ticks. Episodes are handed out
+//! one at a time to a set of worker threads, which live as long as the
+//! runner, so throughput scales with the cores used.
+class WorldRunner {
+public:
+    //! \brief How to run an episode. The functions are called from worker
+    //! threads, several at once, and must only touch the level they are given
+    //! (or state of their own that is safe to share).
+    struct Episode {
+        std::function<std::shared_ptr<Level>(unsigned seed)> create; //!< Build the level for a seed; its generator is then seeded with it.
+        std::function<void(Level& level, unsigned tick)> control; //!< Set the level's input before a tick; may be empty.
+        std::function<bool(const Level& level, float& score)> done; //!< Get if the episode is over after a tick, and its score so far.
+        unsigned maxTicks = 1000;
+    };
+
+    //! \brief What became of one episode.
+    struct Result {
+        unsigned seed;
+        unsigned ticks; //!< ticks run
+        float score; //!< the score done gave last
+        bool finished; //!< if done ended the episode before maxTicks
+    };
+
+    WorldRunner(unsigned threads = 0); //!< Start the workers; 0 uses one per core.
+    ~WorldRunner();
+
+    inline unsigned threadCount() const { return unsigned(mThreads.size()); }
+
+    //! \brief Run an episode for each seed and wait for them all. results[i]
+    //! is the episode of seeds[i].
+    void run(const Episode& episode, const std::vector<unsigned>& seeds, std::vector<Result>& results);
+
+    static Result runEpisode(const Episode& episode, unsigned seed); //!< Run a single episode on the calling thread.
+
+private:
+    WorldRunner(const WorldRunner&) = delete;
+    void operator=(WorldRunner const&) = delete;
+
+    void work();
+
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mStart; //!< signalled when a batch is posted or the runner stops
+    std::condition_variable mFinished; //!< signalled when the last worker leaves a batch
+    unsigned mBatch; //!< counts batches posted, so workers can tell a new one
+    unsigned mBusy; //!< workers still in the current batch
+    bool mStopping;
+
+    // the current batch
+    const Episode* mEpisode;
+    const std::vector<unsigned>* mSeeds;
+    std::vector<Result>* mResults;
+    std::atomic<std::size_t> mNext; //!< next episode to hand out
+};
+
+#endif
@@ -0,0 +1,38 @@
+// Compiles levels from the text form to the binary level format.
+//
+//     main-levelc in.txt out.level
+
+#include "base/LevelFile.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " in.txt out.level" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<char> data;
+    std::string error;
+    if (!LevelFile::compileText(in, data, error)) {
+        std::cerr << argv[1] << ": " << error << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(argv[2], std::ios::binary);
+    out.write(data.data(), std::streamsize(data.size()));
+    if (!out) {
+        std::cerr << "cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Times the pathfinder on a large generated level.
+//
+//     main-pathbench [QUERIES] [--cells N] [--seed N]
+//
+// Builds a level of N x N cells (1000 by default), one fortieth of it
+// covered in solid blocks of up to 6x6 cells, then times QUERIES (1000 by
+// default) path queries between random open cells and reports the time
+// taken to build the pathfinder and the mean, median and worst query.
+
+#include "base/Level.hpp"
+#include "base/PhysicsComponent.hpp"
+#include "base/Pool.hpp"
+#include "base/Random.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    unsigned queries = 1000;
+    int cells = 1000;
+    unsigned seed = 1;
+    for (int ii = 1; ii < argc; ++ii) {
+        if (std::strcmp(argv[ii], "--cells") == 0 && ii + 1 < argc) {
+            cells = std::max(1, std::atoi(argv[++ii]));
+        } else if (std::strcmp(argv[ii], "--seed") == 0 && ii + 1 < argc) {
+            seed = unsigned(std::atoi(argv[++ii]));
+        } else if (argv[ii][0] != '-') {
+            queries = unsigned(std::max(1, std::atoi(argv[ii])));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [QUERIES] [--cells N] [--seed N]" << std::endl;
+            return 1;
+        }
+    }
+
+    Level level(cells * SIZE, cells * SIZE);
+    Random random(seed);
+    std::vector<std::shared_ptr<GameObject>> blocks;
+    for (int ii = 0; ii < cells * cells / 40; ++ii) {
+        const float w = float((1 + random.next(6)) * SIZE);
+        const float h = float((1 + random.next(6)) * SIZE);
+        std::shared_ptr<GameObject> block = makePooled<GameObject>(float(random.next(cells) * SIZE), float(random.next(cells) * SIZE), w, h, 0);
+        block->setPhysicsCompenent(makePooled<PhysicsComponent>(*block, true));
+        blocks.push_back(block);
+    }
+    level.addObjects(blocks);
+
+    // the blocks join the level, and the pathfinder is built, on the first update
+    auto start = std::chrono::steady_clock::now();
+    level.update();
+    std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - start;
+
+    const NavGrid& grid = level.navGrid();
+    auto randomOpenCell = [&grid, &random, cells](float& x, float& y) {
+        int cx, cy;
+        do {
+            cx = random.next(cells);
+            cy = random.next(cells);
+        } while (grid.isBlocked(cx, cy));
+        x = grid.centerX(cx);
+        y = grid.centerY(cy);
+    };
+
+    std::vector<Pathfinder::Point> path;
+    std::vector<double> times;
+    unsigned found = 0;
+    double total = 0.0;
+    for (unsigned ii = 0; ii < queries; ++ii) {
+        float sx, sy, gx, gy;
+        randomOpenCell(sx, sy);
+        randomOpenCell(gx, gy);
+        start = std::chrono::steady_clock::now();
+        found += level.pathfinder().findPath(sx, sy, gx, gy, path);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        total += elapsed.count();
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+
+    std::cout << "first update over " << cells << "x" << cells << " cells, building the pathfinder, in " << build.count() << " ms" << std::endl;
+    std::cout << queries << " queries, " << found << " found, " << total / queries << " ms on average, " << times[queries / 2]
+              << " ms median, " << times[queries * 99 / 100] << " ms 99th percentile, " << times.back() << " ms at most" << std::endl;
+    return 0;
+}